@@ -7,12 +7,23 @@ FlipWiFiApp *flip_wifi_app_alloc()
 
     Gui *gui = furi_record_open(RECORD_GUI);
 
+    // Sized once so JSON tokens and scan results do not fragment the heap
+    // (everything falls back to the heap if this fails). JSON gets its own arena,
+    // owned by this (GUI) thread, so clearing the scan never frees live tokens.
+    app->arena = arena_alloc(FLIP_WIFI_ARENA_SIZE);
+    app->json_arena = arena_alloc(FLIP_WIFI_JSON_ARENA_SIZE);
+    json_set_arena_furi(app->json_arena);
+
     // Allocate ViewDispatcher
     if (!easy_flipper_set_view_dispatcher(&app->view_dispatcher, gui, app))
     {
         return NULL;
     }
 
+    // scan results arrive on the UART worker and are shown through custom events
+    app->scan_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    view_dispatcher_set_custom_event_callback(app->view_dispatcher, callback_custom_event);
+
     // Submenu
     if (!easy_flipper_set_submenu(&app->submenu_main, FlipWiFiViewSubmenuMain, "FlipWiFi v1.3.2", callback_exit_app, &app->view_dispatcher))
     {
@@ -21,6 +32,12 @@ FlipWiFiApp *flip_wifi_app_alloc()
     submenu_add_item(app->submenu_main, "Scan", FlipWiFiSubmenuIndexWiFiScan, callback_submenu_choices, app);
     submenu_add_item(app->submenu_main, "Saved APs", FlipWiFiSubmenuIndexWiFiSaved, callback_submenu_choices, app);
     submenu_add_item(app->submenu_main, "Commands", FlipWiFiSubmenuIndexCommands, callback_submenu_choices, app);
+    submenu_add_item(app->submenu_main, settings_compat_enabled() ? "App Copies: ON" : "App Copies: OFF", FlipWiFiSubmenuIndexSettingsCompat, callback_submenu_choices, app);
+    submenu_add_item(app->submenu_main, "Diagnostics", FlipWiFiSubmenuIndexDiagnostics, callback_submenu_choices, app);
+#if FLIPPER_HTTP_REPLAY
+    submenu_add_item(app->submenu_main, "Capture: OFF", FlipWiFiSubmenuIndexCapture, callback_submenu_choices, app);
+    submenu_add_item(app->submenu_main, "Replay", FlipWiFiSubmenuIndexReplay, callback_submenu_choices, app);
+#endif
     submenu_add_item(app->submenu_main, "Info", FlipWiFiSubmenuIndexAbout, callback_submenu_choices, app);
 
     // Switch to the main view
@@ -1,5 +1,6 @@
 #include <flip_wifi.h>
 #include <alloc/flip_wifi_alloc.h>
+#include <callback/flip_wifi_callback.h>
 
 // Entry point for the FlipWiFi application
 int32_t flip_wifi_main(void *p)
@@ -14,28 +15,11 @@ int32_t flip_wifi_main(void *p)
         return -1;
     }
 
-    // check if board is connected (Derek Jamison)
-    // initialize the http
-    if (flipper_http_init(flipper_http_rx_callback, app))
+    // open the uart session that every screen reuses, then look for the board in the
+    // background while the main menu is already usable
+    if (flipper_http_session_start(flipper_http_rx_callback, app))
     {
-        if (!flipper_http_ping())
-        {
-            FURI_LOG_E(TAG, "Failed to ping the device");
-            return -1;
-        }
-
-        // Try to wait for pong response.
-        uint8_t counter = 10;
-        while (fhttp.state == INACTIVE && --counter > 0)
-        {
-            FURI_LOG_D(TAG, "Waiting for PONG");
-            furi_delay_ms(100);
-        }
-
-        if (counter == 0)
-            easy_flipper_dialog("FlipperHTTP Error", "Ensure your WiFi Developer\nBoard or Pico W is connected\nand the latest FlipperHTTP\nfirmware is installed.");
-
-        flipper_http_deinit();
+        flip_wifi_probe_start(app);
     }
     else
     {
@@ -0,0 +1,74 @@
+#include <arena/arena.h>
+
+#define ARENA_ALIGN 8
+
+Arena *arena_alloc(size_t capacity)
+{
+    Arena *arena = (Arena *)malloc(sizeof(Arena));
+    if (!arena)
+    {
+        FURI_LOG_E("Arena", "Failed to allocate arena");
+        return NULL;
+    }
+    arena->base = (uint8_t *)malloc(capacity);
+    if (!arena->base)
+    {
+        FURI_LOG_E("Arena", "Failed to allocate %zu bytes for arena", capacity);
+        free(arena);
+        return NULL;
+    }
+    arena->capacity = capacity;
+    arena->used = 0;
+    return arena;
+}
+
+void arena_free(Arena *arena)
+{
+    if (!arena)
+        return;
+    free(arena->base);
+    free(arena);
+}
+
+void *arena_push(Arena *arena, size_t size)
+{
+    if (!arena)
+        return NULL;
+    size_t start = (arena->used + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+    if (start > arena->capacity || size > arena->capacity - start)
+        return NULL;
+    arena->used = start + size;
+    return arena->base + start;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t len)
+{
+    char *copy = (char *)arena_push(arena, len + 1);
+    if (!copy)
+        return NULL;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+size_t arena_mark(const Arena *arena)
+{
+    return arena ? arena->used : 0;
+}
+
+void arena_release(Arena *arena, size_t mark)
+{
+    if (arena && mark < arena->used)
+        arena->used = mark;
+}
+
+void arena_reset(Arena *arena)
+{
+    if (arena)
+        arena->used = 0;
+}
+
+bool arena_owns(const Arena *arena, const void *ptr)
+{
+    return arena && (const uint8_t *)ptr >= arena->base && (const uint8_t *)ptr < arena->base + arena->capacity;
+}
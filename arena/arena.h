@@ -0,0 +1,39 @@
+#pragma once
+#include <furi.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fixed-capacity bump allocator: one block sized up front, carved into allocations
+// and handed back in one step (reset, or release to an earlier mark).
+// Not thread safe; use each arena from one thread at a time.
+typedef struct
+{
+    uint8_t *base;   // start of the block
+    size_t capacity; // size of the block
+    size_t used;     // bytes handed out so far
+} Arena;
+
+// Allocate an arena with a fixed capacity (NULL if the block cannot be allocated)
+Arena *arena_alloc(size_t capacity);
+
+// Free an arena and everything carved from it
+void arena_free(Arena *arena);
+
+// Carve an aligned block from the arena (NULL if it does not fit)
+void *arena_push(Arena *arena, size_t size);
+
+// Copy len bytes of a string into the arena, NUL terminated (NULL if it does not fit)
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+
+// Current position, to release back to later
+size_t arena_mark(const Arena *arena);
+
+// Release everything carved since a mark
+void arena_release(Arena *arena, size_t mark);
+
+// Release everything carved from the arena
+void arena_reset(Arena *arena);
+
+// Check whether a pointer was carved from the arena
+bool arena_owns(const Arena *arena, const void *ptr);
@@ -1,11 +1,27 @@
 #include <callback/flip_wifi_callback.h>
 
-static char *ssid_list[64];
+static FlipWiFiScan wifi_scan;             // results of the last scan, strongest first (guarded by app->scan_mutex)
+static FlipWiFiScanRecord *scan_heap = NULL; // scan records when they did not fit in the arena
+static FlipWiFiScanRecord scan_selected;     // copy of the scanned network being viewed
+static volatile uint32_t scan_request_id = 0; // non-zero while a scan is running
+static volatile bool scan_update_pending = false;
+static volatile bool scan_reply_done = false; // the scan parser saw the end of the reply
+static uint32_t scan_timestamp = 0; // RTC time the records were last completed
+#if FLIPPER_HTTP_REPLAY
+static bool replay_capturing = false;         // received bytes are copied to FLIP_WIFI_REPLAY_PATH
+static bool replay_ran = false;               // replay_report holds a result
+static FlipperHTTPReplayReport replay_report; // timings and heap use of the last replay
+static size_t replay_networks = 0;            // networks the scan parser found in the replay
+#endif
+static volatile bool probe_found = false;     // the startup probe got a PONG
+
 static uint32_t ssid_index = 0;
 static char current_ssid[64];
 static char current_password[64];
 
 static void flip_wifi_redraw_submenu_saved(void *context);
+static void flip_wifi_clear_scan(FlipWiFiApp *app);
+static void flip_wifi_cancel_scan(void);
 static void flip_wifi_view_draw_callback_scan(Canvas *canvas, void *model);
 static void flip_wifi_view_draw_callback_saved(Canvas *canvas, void *model);
 static bool flip_wifi_view_input_callback_scan(InputEvent *event, void *context);
@@ -13,12 +29,26 @@ static bool flip_wifi_view_input_callback_saved(InputEvent *event, void *context
 static uint32_t callback_to_submenu_saved(void *context);
 static uint32_t callback_to_submenu_scan(void *context);
 static uint32_t callback_to_submenu_main(void *context);
+static bool flip_wifi_session_ensure(FlipWiFiApp *app);
 
 void flip_wifi_text_updated_password_scan(void *context);
 void flip_wifi_text_updated_password_saved(void *context);
 void flip_wifi_text_updated_add_ssid(void *context);
 void flip_wifi_text_updated_add_password(void *context);
 
+// Function to wait for the reply to a command and show it
+static void flip_wifi_show_response()
+{
+    if (!flipper_http_wait_response(TIMEOUT_DURATION_TICKS))
+    {
+        easy_flipper_dialog("[ERROR]", "No response from the\nWiFi Dev Board.");
+        return;
+    }
+    char response[100];
+    snprintf(response, sizeof(response), "%s", fhttp.last_response);
+    easy_flipper_dialog("", response);
+}
+
 static bool flip_wifi_alloc_playlist(void *context)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
@@ -35,7 +65,7 @@ static bool flip_wifi_alloc_playlist(void *context)
             FURI_LOG_E(TAG, "Failed to allocate playlist");
             return false;
         }
-        wifi_playlist->count = 0;
+        memset(wifi_playlist, 0, sizeof(WiFiPlaylist));
     }
     // Load the playlist from storage
     if (!load_playlist(wifi_playlist))
@@ -58,11 +88,14 @@ static void flip_wifi_free_playlist(void)
 {
     if (wifi_playlist)
     {
+        playlist_release(wifi_playlist);
         free(wifi_playlist);
         wifi_playlist = NULL;
     }
 }
 
+// Function to set up the generic view for the scan or saved screen (allocated on first use,
+// then only its callbacks are swapped)
 static bool flip_wifi_alloc_views(void *context, uint32_t view)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
@@ -71,39 +104,41 @@ static bool flip_wifi_alloc_views(void *context, uint32_t view)
         FURI_LOG_E(TAG, "FlipWiFiApp is NULL");
         return false;
     }
+    void (*draw_callback)(Canvas *, void *);
+    bool (*input_callback)(InputEvent *, void *);
+    uint32_t (*previous_callback)(void *);
     switch (view)
     {
     case FlipWiFiViewWiFiScan:
-        if (!app->view_wifi)
+        draw_callback = flip_wifi_view_draw_callback_scan;
+        input_callback = flip_wifi_view_input_callback_scan;
+        previous_callback = callback_to_submenu_scan;
+        break;
+    case FlipWiFiViewWiFiSaved:
+        draw_callback = flip_wifi_view_draw_callback_saved;
+        input_callback = flip_wifi_view_input_callback_saved;
+        previous_callback = callback_to_submenu_saved;
+        break;
+    default:
+        return false;
+    }
+    if (!app->view_wifi)
+    {
+        if (!easy_flipper_set_view(&app->view_wifi, FlipWiFiViewGeneric, draw_callback, input_callback, previous_callback, &app->view_dispatcher, app))
         {
-            if (!easy_flipper_set_view(&app->view_wifi, FlipWiFiViewGeneric, flip_wifi_view_draw_callback_scan, flip_wifi_view_input_callback_scan, callback_to_submenu_scan, &app->view_dispatcher, app))
-            {
-                return false;
-            }
-            if (!app->view_wifi)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate view for WiFi Scan");
-                return false;
-            }
+            return false;
         }
-        return true;
-    case FlipWiFiViewWiFiSaved:
         if (!app->view_wifi)
         {
-            if (!easy_flipper_set_view(&app->view_wifi, FlipWiFiViewGeneric, flip_wifi_view_draw_callback_saved, flip_wifi_view_input_callback_saved, callback_to_submenu_saved, &app->view_dispatcher, app))
-            {
-                return false;
-            }
-            if (!app->view_wifi)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate view for WiFi Scan");
-                return false;
-            }
+            FURI_LOG_E(TAG, "Failed to allocate view for WiFi");
+            return false;
         }
         return true;
-    default:
-        return false;
     }
+    view_set_draw_callback(app->view_wifi, draw_callback);
+    view_set_input_callback(app->view_wifi, input_callback);
+    view_set_previous_callback(app->view_wifi, previous_callback);
+    return true;
 }
 static void flip_wifi_free_views(void *context)
 {
@@ -115,11 +150,89 @@ static void flip_wifi_free_views(void *context)
     }
     if (app->view_wifi)
     {
-        free(app->view_wifi);
-        app->view_wifi = NULL;
         view_dispatcher_remove_view(app->view_dispatcher, FlipWiFiViewGeneric);
+        view_free(app->view_wifi);
+        app->view_wifi = NULL;
+    }
+}
+// Function to write the FlipperHTTP counters as the diagnostics text
+static void flip_wifi_diagnostics_text(char *text, size_t size)
+{
+    FlipperHTTPStats last, total;
+    flipper_http_get_stats(&last, &total);
+    uint32_t requests = total.requests ? total.requests : 1; // for the averages
+#if FLIPPER_HTTP_REPLAY
+    if (replay_ran)
+    {
+        int length = snprintf(
+            text,
+            size,
+            "Replay\n"
+            "%lu B in %lu ms\n"
+            "Rate: %lu B/s\n"
+            "Dropped: %lu B\n"
+            "Heap min: %zu B free\n"
+            "Heap used: %d B\n"
+            "Worker alloc: %zu B peak, %zu B kept\n"
+            "Worker stack free: %lu B\n"
+            "Networks parsed: %zu\n"
+            "-----\n",
+            replay_report.bytes,
+            replay_report.elapsed_ms,
+            replay_report.bytes_per_second,
+            replay_report.dropped_bytes,
+            replay_report.heap_min,
+            (int)replay_report.heap_before - (int)replay_report.heap_after,
+            replay_report.worker_heap_peak,
+            replay_report.worker_heap_after,
+            replay_report.stack_free,
+            replay_networks);
+        if (length > 0 && (size_t)length < size)
+        {
+            text += length;
+            size -= length;
+        }
     }
+#endif
+    snprintf(
+        text,
+        size,
+        "Last request\n"
+        "First byte: %lu ms\n"
+        "Transfer: %lu ms\n"
+        "Received: %lu B, %lu lines\n"
+        "SD write: %lu ms\n"
+        "Buffer peak: %lu B\n"
+        "Dropped: %lu B\n"
+        "-----\n"
+        "Session: %lu requests\n"
+        "Avg first byte: %lu ms\n"
+        "Avg transfer: %lu ms\n"
+        "Received: %lu B, %lu lines\n"
+        "SD write: %lu ms\n"
+        "Buffer peak: %lu B\n"
+        "Dropped: %lu B\n"
+        "Timeouts: %lu",
+        last.first_byte_ms,
+        last.transfer_ms,
+        last.bytes_received,
+        last.lines_received,
+        last.sd_write_ms,
+        last.stream_high_water,
+        last.dropped_bytes,
+        total.requests,
+        total.first_byte_ms / requests,
+        total.transfer_ms / requests,
+        total.bytes_received,
+        total.lines_received,
+        total.sd_write_ms,
+        total.stream_high_water,
+        total.dropped_bytes,
+        total.timeouts);
 }
+
+// Function to set up a widget screen (allocated on first use, the diagnostics text is
+// rebuilt on every visit)
 static bool flip_wifi_alloc_widgets(void *context, uint32_t widget)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
@@ -144,6 +257,27 @@ static bool flip_wifi_alloc_widgets(void *context, uint32_t widget)
             }
         }
         return true;
+    case FlipWiFiViewDiagnostics:
+    {
+        char text[640];
+        flip_wifi_diagnostics_text(text, sizeof(text));
+        if (app->widget_diagnostics)
+        {
+            widget_reset(app->widget_diagnostics);
+            widget_add_text_scroll_element(app->widget_diagnostics, 0, 0, 128, 64, text);
+            return true;
+        }
+        if (!easy_flipper_set_widget(&app->widget_diagnostics, FlipWiFiViewDiagnostics, text, callback_to_submenu_main, &app->view_dispatcher))
+        {
+            return false;
+        }
+        if (!app->widget_diagnostics)
+        {
+            FURI_LOG_E(TAG, "Failed to allocate widget for Diagnostics");
+            return false;
+        }
+        return true;
+    }
     default:
         return false;
     }
@@ -158,11 +292,19 @@ static void flip_wifi_free_widgets(void *context)
     }
     if (app->widget_info)
     {
-        free(app->widget_info);
-        app->widget_info = NULL;
         view_dispatcher_remove_view(app->view_dispatcher, FlipWiFiViewAbout);
+        widget_free(app->widget_info);
+        app->widget_info = NULL;
+    }
+    if (app->widget_diagnostics)
+    {
+        view_dispatcher_remove_view(app->view_dispatcher, FlipWiFiViewDiagnostics);
+        widget_free(app->widget_diagnostics);
+        app->widget_diagnostics = NULL;
     }
 }
+// Function to set up the generic submenu for the scan, saved or commands screen (allocated
+// on first use, then reset and refilled)
 static bool flip_wifi_alloc_submenus(void *context, uint32_t view)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
@@ -171,63 +313,59 @@ static bool flip_wifi_alloc_submenus(void *context, uint32_t view)
         FURI_LOG_E(TAG, "FlipWiFiApp is NULL");
         return false;
     }
+    char *header;
     switch (view)
     {
     case FlipWiFiViewSubmenuScan:
-        if (!app->submenu_wifi)
+        header = "WiFi Nearby";
+        break;
+    case FlipWiFiViewSubmenuSaved:
+        header = "Saved APs";
+        break;
+    case FlipWiFiViewSubmenuCommands:
+        header = "Fast Commands";
+        break;
+    default:
+        return false;
+    }
+    if (!app->submenu_wifi)
+    {
+        if (!easy_flipper_set_submenu(&app->submenu_wifi, FlipWiFiViewSubmenu, header, callback_to_submenu_main, &app->view_dispatcher))
         {
-            if (!easy_flipper_set_submenu(&app->submenu_wifi, FlipWiFiViewSubmenu, "WiFi Nearby", callback_to_submenu_main, &app->view_dispatcher))
-            {
-                return false;
-            }
-            if (!app->submenu_wifi)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate submenu for WiFi Scan");
-                return false;
-            }
+            return false;
         }
-        return true;
-    case FlipWiFiViewSubmenuSaved:
         if (!app->submenu_wifi)
         {
-            if (!easy_flipper_set_submenu(&app->submenu_wifi, FlipWiFiViewSubmenu, "Saved APs", callback_to_submenu_main, &app->view_dispatcher))
-            {
-                return false;
-            }
-            if (!app->submenu_wifi)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate submenu for WiFi Saved");
-                return false;
-            }
-            if (!flip_wifi_alloc_playlist(app))
-            {
-                FURI_LOG_E(TAG, "Failed to allocate playlist");
-                return false;
-            }
+            FURI_LOG_E(TAG, "Failed to allocate submenu for WiFi");
+            return false;
         }
-        return true;
-    case FlipWiFiViewSubmenuCommands:
-        if (!app->submenu_wifi)
+    }
+    else
+    {
+        submenu_reset(app->submenu_wifi);
+        submenu_set_header(app->submenu_wifi, header);
+    }
+    switch (view)
+    {
+    case FlipWiFiViewSubmenuSaved:
+        if (!flip_wifi_alloc_playlist(app))
         {
-            if (!easy_flipper_set_submenu(&app->submenu_wifi, FlipWiFiViewSubmenu, "Fast Commands", callback_to_submenu_main, &app->view_dispatcher))
-            {
-                return false;
-            }
-            if (!app->submenu_wifi)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate submenu for Commands");
-                return false;
-            }
-            //  PING, LIST, WIFI/LIST, IP/ADDRESS, and WIFI/IP.
-            submenu_add_item(app->submenu_wifi, "[CUSTOM]", FlipWiFiSubmenuIndexFastCommandStart + 0, callback_submenu_choices, app);
-            submenu_add_item(app->submenu_wifi, "PING", FlipWiFiSubmenuIndexFastCommandStart + 1, callback_submenu_choices, app);
-            submenu_add_item(app->submenu_wifi, "LIST", FlipWiFiSubmenuIndexFastCommandStart + 2, callback_submenu_choices, app);
-            submenu_add_item(app->submenu_wifi, "IP/ADDRESS", FlipWiFiSubmenuIndexFastCommandStart + 3, callback_submenu_choices, app);
-            submenu_add_item(app->submenu_wifi, "WIFI/IP", FlipWiFiSubmenuIndexFastCommandStart + 4, callback_submenu_choices, app);
+            FURI_LOG_E(TAG, "Failed to allocate playlist");
+            return false;
         }
-        return true;
+        break;
+    case FlipWiFiViewSubmenuCommands:
+        //  PING, LIST, WIFI/LIST, IP/ADDRESS, and WIFI/IP.
+        submenu_add_item(app->submenu_wifi, "[CUSTOM]", FlipWiFiSubmenuIndexFastCommandStart + 0, callback_submenu_choices, app);
+        submenu_add_item(app->submenu_wifi, "PING", FlipWiFiSubmenuIndexFastCommandStart + 1, callback_submenu_choices, app);
+        submenu_add_item(app->submenu_wifi, "LIST", FlipWiFiSubmenuIndexFastCommandStart + 2, callback_submenu_choices, app);
+        submenu_add_item(app->submenu_wifi, "IP/ADDRESS", FlipWiFiSubmenuIndexFastCommandStart + 3, callback_submenu_choices, app);
+        submenu_add_item(app->submenu_wifi, "WIFI/IP", FlipWiFiSubmenuIndexFastCommandStart + 4, callback_submenu_choices, app);
+        break;
+    default:
+        break;
     }
-    return false;
+    return true;
 }
 static void flip_wifi_free_submenus(void *context)
 {
@@ -239,9 +377,9 @@ static void flip_wifi_free_submenus(void *context)
     }
     if (app->submenu_wifi)
     {
-        free(app->submenu_wifi);
-        app->submenu_wifi = NULL;
         view_dispatcher_remove_view(app->view_dispatcher, FlipWiFiViewSubmenu);
+        submenu_free(app->submenu_wifi);
+        app->submenu_wifi = NULL;
     }
 }
 
@@ -264,19 +402,15 @@ static void flip_wifi_custom_command_updated(void *context)
         return;
     }
     // Send the custom command
-    flipper_http_send_data(app->uart_text_input_temp_buffer);
-    while (fhttp.last_response == NULL || strlen(fhttp.last_response) == 0)
+    if (flipper_http_send_data(app->uart_text_input_temp_buffer))
     {
-        furi_delay_ms(100);
+        flip_wifi_show_response();
     }
-    // Switch to the view
-    char response[100];
-    snprintf(response, sizeof(response), "%s", fhttp.last_response);
-    easy_flipper_dialog("", response);
-    flipper_http_deinit();
     view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewSubmenu);
 }
 
+// Function to set up the text input for one of its uses (the input and its buffers are
+// allocated on first use, then the model is reset and pointed at the new callback)
 static bool flip_wifi_alloc_text_inputs(void *context, uint32_t view)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
@@ -312,85 +446,67 @@ static bool flip_wifi_alloc_text_inputs(void *context, uint32_t view)
             return false;
         }
     }
+    char *header;
+    void (*result_callback)(void *);
+    uint32_t (*previous_callback)(void *);
     switch (view)
     {
     case FlipWiFiViewTextInputScan:
-        if (!app->uart_text_input)
-        {
-            if (!easy_flipper_set_uart_text_input(&app->uart_text_input, FlipWiFiViewTextInput, "Enter WiFi Password", app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, flip_wifi_text_updated_password_scan, callback_to_submenu_scan, &app->view_dispatcher, app))
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Scan");
-                return false;
-            }
-            if (!app->uart_text_input)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Scan");
-                return false;
-            }
-        }
-        return true;
+        header = "Enter WiFi Password";
+        result_callback = flip_wifi_text_updated_password_scan;
+        previous_callback = callback_to_submenu_scan;
+        break;
     case FlipWiFiViewTextInputSaved:
-        if (!app->uart_text_input)
-        {
-            if (!easy_flipper_set_uart_text_input(&app->uart_text_input, FlipWiFiViewTextInput, "Enter WiFi Password", app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, flip_wifi_text_updated_password_saved, callback_to_submenu_saved, &app->view_dispatcher, app))
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved");
-                return false;
-            }
-            if (!app->uart_text_input)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved");
-                return false;
-            }
-        }
-        return true;
+        header = "Enter WiFi Password";
+        result_callback = flip_wifi_text_updated_password_saved;
+        previous_callback = callback_to_submenu_saved;
+        break;
     case FlipWiFiViewTextInputSavedAddSSID:
-        if (!app->uart_text_input)
-        {
-            if (!easy_flipper_set_uart_text_input(&app->uart_text_input, FlipWiFiViewTextInput, "Enter SSID", app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, flip_wifi_text_updated_add_ssid, callback_to_submenu_saved, &app->view_dispatcher, app))
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved Add SSID");
-                return false;
-            }
-            if (!app->uart_text_input)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved Add SSID");
-                return false;
-            }
-        }
-        return true;
+        header = "Enter SSID";
+        result_callback = flip_wifi_text_updated_add_ssid;
+        previous_callback = callback_to_submenu_saved;
+        break;
     case FlipWiFiViewTextInputSavedAddPassword:
-        if (!app->uart_text_input)
+        header = "Enter Password";
+        result_callback = flip_wifi_text_updated_add_password;
+        previous_callback = callback_to_submenu_saved;
+        break;
+    case FlipWiFiSubmenuIndexFastCommandStart:
+        header = "Enter Command";
+        result_callback = flip_wifi_custom_command_updated;
+        previous_callback = callback_to_submenu_saved;
+        break;
+    default:
+        return false;
+    }
+    // editing a saved network starts from its current password
+    if (view == FlipWiFiViewTextInputSaved)
+    {
+        snprintf(app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, "%s", current_password);
+    }
+    else
+    {
+        app->uart_text_input_temp_buffer[0] = '\0';
+    }
+    if (!app->uart_text_input)
+    {
+        if (!easy_flipper_set_uart_text_input(&app->uart_text_input, FlipWiFiViewTextInput, header, app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, result_callback, previous_callback, &app->view_dispatcher, app))
         {
-            if (!easy_flipper_set_uart_text_input(&app->uart_text_input, FlipWiFiViewTextInput, "Enter Password", app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, flip_wifi_text_updated_add_password, callback_to_submenu_saved, &app->view_dispatcher, app))
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved Add Password");
-                return false;
-            }
-            if (!app->uart_text_input)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved Add Password");
-                return false;
-            }
+            FURI_LOG_E(TAG, "Failed to allocate text input");
+            return false;
         }
-        return true;
-    case FlipWiFiSubmenuIndexFastCommandStart:
         if (!app->uart_text_input)
         {
-            if (!easy_flipper_set_uart_text_input(&app->uart_text_input, FlipWiFiViewTextInput, "Enter Command", app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, flip_wifi_custom_command_updated, callback_to_submenu_saved, &app->view_dispatcher, app))
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for Fast Command");
-                return false;
-            }
-            if (!app->uart_text_input)
-            {
-                FURI_LOG_E(TAG, "Failed to allocate text input for Fast Command");
-                return false;
-            }
+            FURI_LOG_E(TAG, "Failed to allocate text input");
+            return false;
         }
         return true;
     }
-    return false;
+    uart_text_input_reset(app->uart_text_input);
+    uart_text_input_set_header_text(app->uart_text_input, header);
+    uart_text_input_set_result_callback(app->uart_text_input, result_callback, app, app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, false);
+    view_set_previous_callback(uart_text_input_get_view(app->uart_text_input), previous_callback);
+    return true;
 }
 static void flip_wifi_free_text_inputs(void *context)
 {
@@ -402,9 +518,9 @@ static void flip_wifi_free_text_inputs(void *context)
     }
     if (app->uart_text_input)
     {
-        free(app->uart_text_input);
-        app->uart_text_input = NULL;
         view_dispatcher_remove_view(app->view_dispatcher, FlipWiFiViewTextInput);
+        uart_text_input_free(app->uart_text_input);
+        app->uart_text_input = NULL;
     }
     if (app->uart_text_input_buffer)
     {
@@ -418,6 +534,82 @@ static void flip_wifi_free_text_inputs(void *context)
     }
 }
 
+// Startup probe, run off the GUI thread so the main menu is usable right away
+static int32_t flip_wifi_probe_worker(void *context)
+{
+    FlipWiFiApp *app = (FlipWiFiApp *)context;
+
+    // check if board is connected (Derek Jamison)
+#if FLIPPER_HTTP_BAUDRATE_NEGOTIATION
+    if (flipper_http_ping_wait(1000))
+    {
+        // move to the faster link if the board supports it
+        flipper_http_negotiate_baudrate(BAUDRATE_HIGH);
+    }
+#else
+    flipper_http_ping_wait(1000);
+#endif
+    probe_found = fhttp.state != INACTIVE;
+    if (!probe_found)
+    {
+        // free the port until an action needs it again
+        flipper_http_deinit();
+    }
+    view_dispatcher_send_custom_event(app->view_dispatcher, FlipWiFiCustomEventProbeDone);
+    return 0;
+}
+
+// Function to start probing the board over the open session (the result shows in the main menu header)
+bool flip_wifi_probe_start(void *context)
+{
+    FlipWiFiApp *app = (FlipWiFiApp *)context;
+    if (!app)
+    {
+        FURI_LOG_E(TAG, "FlipWiFiApp is NULL");
+        return false;
+    }
+    app->probe_thread = furi_thread_alloc();
+    if (!app->probe_thread)
+    {
+        FURI_LOG_E(TAG, "Failed to allocate the probe thread");
+        return false;
+    }
+    furi_thread_set_name(app->probe_thread, "FlipWiFi_Probe");
+    furi_thread_set_stack_size(app->probe_thread, FLIP_WIFI_PROBE_STACK_SIZE);
+    furi_thread_set_context(app->probe_thread, app);
+    furi_thread_set_callback(app->probe_thread, flip_wifi_probe_worker);
+    submenu_set_header(app->submenu_main, "FlipWiFi (probing)");
+    furi_thread_start(app->probe_thread);
+    return true;
+}
+
+// Function to wait for the startup probe, so a screen never talks to the board alongside it
+static void flip_wifi_probe_wait(FlipWiFiApp *app)
+{
+    if (app->probe_thread)
+    {
+        furi_thread_join(app->probe_thread);
+        furi_thread_free(app->probe_thread);
+        app->probe_thread = NULL;
+    }
+}
+
+// Function to take over the session the probe left open (reconnects if it was closed)
+static bool flip_wifi_session_ensure(FlipWiFiApp *app)
+{
+    flip_wifi_probe_wait(app);
+    return flipper_http_session_ensure();
+}
+
+// Function to leave the current screen: the screens stay allocated and registered,
+// only the work tied to the screen being left is stopped
+static void flip_wifi_leave_screen(void)
+{
+    // the records stay cached for the next visit to the Scan menu
+    flip_wifi_cancel_scan();
+    memset(&scan_selected, 0, sizeof(scan_selected));
+}
+
 void flip_wifi_free_all(void *context)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
@@ -426,6 +618,8 @@ void flip_wifi_free_all(void *context)
         FURI_LOG_E(TAG, "FlipWiFiApp is NULL");
         return;
     }
+    flip_wifi_probe_wait(app);
+    flip_wifi_leave_screen();
     flip_wifi_free_views(app);
     flip_wifi_free_widgets(app);
     flip_wifi_free_submenus(app);
@@ -455,15 +649,21 @@ static void flip_wifi_redraw_submenu_saved(void *context)
     submenu_reset(app->submenu_wifi);
     submenu_set_header(app->submenu_wifi, "Saved APs");
     submenu_add_item(app->submenu_wifi, "[Add Network]", FlipWiFiSubmenuIndexWiFiSavedAddSSID, callback_submenu_choices, app);
+    if (wifi_playlist->count > 0)
+    {
+        submenu_add_item(app->submenu_wifi, "[Connect Best Known]", FlipWiFiSubmenuIndexWiFiSavedConnectBest, callback_submenu_choices, app);
+    }
     for (size_t i = 0; i < wifi_playlist->count; i++)
     {
-        submenu_add_item(app->submenu_wifi, wifi_playlist->ssids[i], FlipWiFiSubmenuIndexWiFiSavedStart + i, callback_submenu_choices, app);
+        submenu_add_item(app->submenu_wifi, playlist_ssid(wifi_playlist, i), FlipWiFiSubmenuIndexWiFiSavedStart + i, callback_submenu_choices, app);
     }
 }
 
 static uint32_t callback_to_submenu_main(void *context)
 {
     UNUSED(context);
+    // Back out of a running scan: stop listening, the board finishes on its own
+    flip_wifi_cancel_scan();
     ssid_index = 0;
     return FlipWiFiViewSubmenuMain;
 }
@@ -491,7 +691,16 @@ static void flip_wifi_view_draw_callback_scan(Canvas *canvas, void *model)
     UNUSED(model);
     canvas_clear(canvas);
     canvas_set_font(canvas, FontPrimary);
-    canvas_draw_str(canvas, 0, 10, ssid_list[ssid_index]);
+    const FlipWiFiScanRecord *record = &scan_selected;
+    canvas_draw_str(canvas, 0, 10, record->ssid);
+    canvas_set_font(canvas, FontSecondary);
+    if (record->rssi != FLIP_WIFI_SCAN_RSSI_UNKNOWN)
+    {
+        char details[40];
+        snprintf(details, sizeof(details), "%d dBm  Ch %u  %s", record->rssi, record->channel, flip_wifi_scan_auth_name(record->auth));
+        canvas_draw_str(canvas, 0, 22, details);
+    }
+    canvas_set_font(canvas, FontPrimary);
     canvas_draw_icon(canvas, 0, 53, &I_ButtonBACK_10x8);
     canvas_draw_str_aligned(canvas, 12, 54, AlignLeft, AlignTop, "Back");
     canvas_draw_icon(canvas, 96, 53, &I_ButtonRight_4x7);
@@ -524,7 +733,6 @@ static bool flip_wifi_view_input_callback_scan(InputEvent *event, void *context)
     if (event->type == InputTypePress && event->key == InputKeyRight)
     {
         // switch to text input to set password
-        flip_wifi_free_text_inputs(app);
         if (!flip_wifi_alloc_text_inputs(app, FlipWiFiViewTextInputScan))
         {
             FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved Add Password");
@@ -535,6 +743,78 @@ static bool flip_wifi_view_input_callback_scan(InputEvent *event, void *context)
     }
     return false;
 }
+// Function to make a saved network the one every app and the board use (returns false with
+// the reason in *error). When the board last accepted these exact credentials and they are
+// already the active ones, the settings fan-out and [WIFI/SAVE] are skipped and only the
+// connection is checked, reconnecting if the board is offline.
+static bool flip_wifi_activate_network(FlipWiFiApp *app, size_t index, const char *ssid, const char *password, const char **error)
+{
+    const uint32_t hash = credentials_hash(ssid, password);
+    char active_ssid[64];
+    char active_password[64];
+    const bool cached = last_good_matches(hash) &&
+                        load_active_credentials(active_ssid, sizeof(active_ssid), active_password, sizeof(active_password)) &&
+                        strcmp(active_ssid, ssid) == 0 && strcmp(active_password, password) == 0;
+    if (!cached)
+    {
+        // make the selected network the active one in the shared credentials store
+        if (!playlist_set_active(index))
+        {
+            *error = "Failed to save credentials";
+            return false;
+        }
+        // older FlipperHTTP apps only read their own settings.bin
+        if (settings_compat_enabled())
+        {
+            save_settings(ssid, password);
+        }
+    }
+
+    // reuse the uart session (reconnects if the port was lost)
+    if (!flip_wifi_session_ensure(app))
+    {
+        *error = "Failed to initialize flipper http";
+        return false;
+    }
+
+    if (cached)
+    {
+        if (!flipper_http_ip_wifi())
+        {
+            *error = "Failed to check the\nWiFi connection";
+            return false;
+        }
+        if (flipper_http_wait_response(TIMEOUT_DURATION_TICKS) && fhttp.state != ISSUE)
+        {
+            return true;
+        }
+        // the board knows the network but is offline: connect with what it has saved
+        if (!flipper_http_connect_wifi())
+        {
+            *error = "Failed to connect to WiFi";
+            return false;
+        }
+    }
+    else if (!flipper_http_save_wifi(ssid, password))
+    {
+        *error = "Failed to save WiFi settings";
+        return false;
+    }
+
+    if (!flipper_http_wait_response(TIMEOUT_DURATION_TICKS))
+    {
+        *error = "No response from the\nWiFi Dev Board.";
+        return false;
+    }
+    if (fhttp.state == ISSUE)
+    {
+        *error = "The board could not\nconnect to the network.";
+        return false;
+    }
+    last_good_save(hash);
+    return true;
+}
+
 // Input callback for the view (async input handling)
 static bool flip_wifi_view_input_callback_saved(InputEvent *event, void *context)
 {
@@ -546,10 +826,7 @@ static bool flip_wifi_view_input_callback_saved(InputEvent *event, void *context
     }
     if (event->type == InputTypePress && event->key == InputKeyRight)
     {
-        // set text input buffer as the selected password
-        strncpy(app->uart_text_input_temp_buffer, wifi_playlist->passwords[ssid_index], app->uart_text_input_buffer_size);
-        // switch to text input to set password
-        flip_wifi_free_text_inputs(app);
+        // switch to text input to set password (starts from the selected password)
         if (!flip_wifi_alloc_text_inputs(app, FlipWiFiViewTextInputSaved))
         {
             FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved");
@@ -560,59 +837,22 @@ static bool flip_wifi_view_input_callback_saved(InputEvent *event, void *context
     }
     else if (event->type == InputTypePress && event->key == InputKeyOk)
     {
-        // save the settings
-        save_settings(wifi_playlist->ssids[ssid_index], wifi_playlist->passwords[ssid_index]);
-
-        // initialize uart
-        if (!flipper_http_init(flipper_http_rx_callback, app))
+        const char *error = NULL;
+        if (!flip_wifi_activate_network(app, ssid_index, current_ssid, current_password, &error))
         {
-            easy_flipper_dialog("[ERROR]", "Failed to initialize flipper http");
-            return false;
-        }
-
-        // clear response
-        if (fhttp.last_response)
-            snprintf(fhttp.last_response, RX_BUF_SIZE, "%s", "");
-
-        if (!flipper_http_save_wifi(wifi_playlist->ssids[ssid_index], wifi_playlist->passwords[ssid_index]))
-        {
-            easy_flipper_dialog("[ERROR]", "Failed to save WiFi settings");
-            return false;
+            easy_flipper_dialog("[ERROR]", (char *)error);
+            return true;
         }
-
-        while (!fhttp.last_response || strlen(fhttp.last_response) == 0)
-        {
-            furi_delay_ms(100);
-        }
-
-        flipper_http_deinit();
-
         easy_flipper_dialog("[SUCCESS]", "All FlipperHTTP apps will now\nuse the selected network.");
         return true;
     }
     else if (event->type == InputTypePress && event->key == InputKeyLeft)
     {
-        // shift the remaining ssids and passwords
-        for (uint32_t i = ssid_index; i < wifi_playlist->count - 1; i++)
-        {
-            // Use strncpy to prevent buffer overflows and ensure null termination
-            strncpy(wifi_playlist->ssids[i], wifi_playlist->ssids[i + 1], MAX_SSID_LENGTH - 1);
-            wifi_playlist->ssids[i][MAX_SSID_LENGTH - 1] = '\0'; // Ensure null-termination
+        // drop the ssid from the index (compacts the pool)
+        playlist_remove(wifi_playlist, ssid_index);
 
-            strncpy(wifi_playlist->passwords[i], wifi_playlist->passwords[i + 1], MAX_SSID_LENGTH - 1);
-            wifi_playlist->passwords[i][MAX_SSID_LENGTH - 1] = '\0'; // Ensure null-termination
-
-            // Shift ssid_list
-            ssid_list[i] = ssid_list[i + 1];
-        }
-        wifi_playlist->count--;
-
-        // delete the last ssid and password
-        wifi_playlist->ssids[wifi_playlist->count][0] = '\0';
-        wifi_playlist->passwords[wifi_playlist->count][0] = '\0';
-
-        // save the playlist to storage
-        save_playlist(wifi_playlist);
+        // remove the record from storage
+        playlist_delete_record(ssid_index);
 
         // re draw the saved submenu
         flip_wifi_redraw_submenu_saved(app);
@@ -623,131 +863,296 @@ static bool flip_wifi_view_input_callback_saved(InputEvent *event, void *context
     return false;
 }
 
-// Function to trim leading and trailing whitespace
-// Returns the trimmed start pointer and updates the length
-static char *trim_whitespace(char *start, size_t *length)
+// Function to stop listening to a running scan (the records seen so far stay)
+static void flip_wifi_cancel_scan(void)
 {
-    // Trim leading whitespace
-    while (*length > 0 && isspace((unsigned char)*start))
+    if (scan_request_id != 0)
     {
-        start++;
-        (*length)--;
-    }
-
-    // Trim trailing whitespace
-    while (*length > 0 && isspace((unsigned char)start[*length - 1]))
-    {
-        (*length)--;
+        flipper_http_set_line_callback(NULL, NULL);
+        scan_request_id = 0;
     }
+}
 
-    return start;
+// Function to drop the records of the previous scan
+static void flip_wifi_clear_scan(FlipWiFiApp *app)
+{
+    flip_wifi_cancel_scan();
+    // wait out a line still being parsed on the worker
+    furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+    flip_wifi_scan_begin(&wifi_scan, NULL, 0);
+    furi_mutex_release(app->scan_mutex);
+    memset(&scan_selected, 0, sizeof(scan_selected));
+    free(scan_heap);
+    scan_heap = NULL;
+    scan_timestamp = 0;
+    arena_reset(app->arena);
 }
 
-static bool flip_wifi_handle_scan(void *context)
+void flip_wifi_free_scan(void *context)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
     if (!app)
     {
         FURI_LOG_E(TAG, "FlipWiFiApp is NULL");
-        return false;
+        return;
     }
-    // load the received data from the saved file
-    FuriString *scan_data = flipper_http_load_from_file(fhttp.file_path);
-    if (scan_data == NULL)
+    flip_wifi_clear_scan(app);
+}
+
+// Function to set up the scan records, filled from scan.txt on the first visit
+static bool flip_wifi_alloc_scan(FlipWiFiApp *app)
+{
+    if (wifi_scan.records)
     {
-        FURI_LOG_E(TAG, "Failed to load received data from file.");
-        fhttp.state = ISSUE;
-        easy_flipper_dialog("[ERROR]", "Failed to load data from /apps_data/flip_wifi/data/scan.txt");
+        return true;
+    }
+    // the records sit at the bottom of the arena for the whole session
+    const size_t size = MAX_SCAN_NETWORKS * sizeof(FlipWiFiScanRecord);
+    FlipWiFiScanRecord *records = arena_push(app->arena, size);
+    if (records == NULL)
+    {
+        scan_heap = malloc(size);
+        records = scan_heap;
+    }
+    if (records == NULL)
+    {
+        FURI_LOG_E(TAG, "Failed to allocate scan records");
         return false;
     }
-
-    uint32_t ssid_count = 0;
-
-    char *current_position = (char *)furi_string_get_cstr(scan_data);
-    char *next_comma = NULL;
-
-    // Manually split the string on commas
-    while ((next_comma = strchr(current_position, ',')) != NULL)
+    furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+    flip_wifi_scan_begin(&wifi_scan, records, MAX_SCAN_NETWORKS);
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    if (!flip_wifi_scan_load(&wifi_scan, storage, FLIP_WIFI_SCAN_CACHE_PATH, &scan_timestamp))
     {
-        // Calculate length of the SSID
-        size_t ssid_length = next_comma - current_position;
+        scan_timestamp = 0;
+    }
+    furi_record_close(RECORD_STORAGE);
+    furi_mutex_release(app->scan_mutex);
+    return true;
+}
 
-        // Trim leading and trailing whitespace
-        size_t trimmed_length = ssid_length;
-        char *trim_start = trim_whitespace(current_position, &trimmed_length);
+// Function to connect to the strongest network of the latest scan that is also saved,
+// moving on to the next one if the board cannot connect
+static void flip_wifi_connect_best_known(FlipWiFiApp *app)
+{
+    if (!wifi_playlist || !flip_wifi_alloc_scan(app))
+    {
+        easy_flipper_dialog("[ERROR]", "Failed to load the\nsaved networks.");
+        return;
+    }
 
-        // Handle empty SSIDs resulting from consecutive commas
-        if (trimmed_length == 0)
+    // saved networks in the order of the scan records, strongest first
+    uint16_t candidates[MAX_SCAN_NETWORKS];
+    size_t count = 0;
+    furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+    for (size_t i = 0; i < wifi_scan.count && count < MAX_SCAN_NETWORKS; i++)
+    {
+        for (size_t j = 0; j < wifi_playlist->count; j++)
         {
-            current_position = next_comma + 1; // Move past the comma
-            continue;
+            if (strcmp(wifi_scan.records[i].ssid, playlist_ssid(wifi_playlist, j)) == 0)
+            {
+                candidates[count++] = j;
+                break;
+            }
         }
+    }
+    furi_mutex_release(app->scan_mutex);
+    if (count == 0)
+    {
+        easy_flipper_dialog("[ERROR]", "No saved network was\nin the last scan.\nRun Scan first.");
+        return;
+    }
 
-        // Allocate memory for the SSID and copy it
-        ssid_list[ssid_count] = malloc(trimmed_length + 1);
-        if (ssid_list[ssid_count] == NULL)
+    const char *error = NULL;
+    for (size_t i = 0; i < count; i++)
+    {
+        char ssid[64];
+        char password[64];
+        if (!playlist_load_record(candidates[i], ssid, sizeof(ssid), password, sizeof(password)))
         {
-            FURI_LOG_E(TAG, "Memory allocation failed");
-            easy_flipper_dialog("[ERROR]", "Memory allocation failed");
-            furi_string_free(scan_data);
-            return false;
+            continue;
         }
-        strncpy(ssid_list[ssid_count], trim_start, trimmed_length);
-        ssid_list[ssid_count][trimmed_length] = '\0'; // Null-terminate the string
-
-        ssid_count++;
-        if (ssid_count >= MAX_SCAN_NETWORKS)
+        if (flip_wifi_activate_network(app, candidates[i], ssid, password, &error))
         {
-            FURI_LOG_E(TAG, "Maximum SSID limit reached");
-            break;
+            char message[128];
+            snprintf(message, sizeof(message), "Connected to %s.\nAll FlipperHTTP apps will now\nuse it.", ssid);
+            easy_flipper_dialog("[SUCCESS]", message);
+            return;
         }
+        FURI_LOG_E(TAG, "Best known network %s failed: %s", ssid, error);
+    }
+    easy_flipper_dialog("[ERROR]", error ? (char *)error : "Failed to load the\nsaved networks.");
+}
 
-        current_position = next_comma + 1; // Move past the comma
+// Function to check whether the cached records are recent enough to show
+static bool flip_wifi_scan_is_fresh(void)
+{
+    uint32_t now = furi_hal_rtc_get_timestamp();
+    // a clock set backwards makes the cache look stale, never fresh
+    return wifi_scan.count > 0 && scan_timestamp != 0 && now >= scan_timestamp && now - scan_timestamp < FLIP_WIFI_SCAN_CACHE_SECONDS;
+}
+
+// Function to save the finished scan with the time it completed
+static void flip_wifi_save_scan(FlipWiFiApp *app)
+{
+    scan_timestamp = furi_hal_rtc_get_timestamp();
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    storage_common_mkdir(storage, STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi");
+    storage_common_mkdir(storage, STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data");
+    furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+    if (!flip_wifi_scan_save(&wifi_scan, storage, FLIP_WIFI_SCAN_CACHE_PATH, scan_timestamp))
+    {
+        FURI_LOG_E(TAG, "Failed to save the scan results");
     }
+    furi_mutex_release(app->scan_mutex);
+    furi_record_close(RECORD_STORAGE);
+}
 
-    // Handle the last SSID after the last comma (if any)
-    if (*current_position != '\0' && ssid_count < MAX_SCAN_NETWORKS)
+// Function to feed a reply line to the scan (UART worker thread)
+static bool flip_wifi_scan_line(const char *line, size_t length, void *context)
+{
+    FlipWiFiApp *app = (FlipWiFiApp *)context;
+    furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+    bool done = flip_wifi_scan_feed_line(line, length, &wifi_scan);
+    furi_mutex_release(app->scan_mutex);
+    // the scan is over once its array or object closes, whatever else the board sends
+    if (done && !scan_reply_done)
+    {
+        scan_reply_done = true;
+        view_dispatcher_send_custom_event(app->view_dispatcher, FlipWiFiCustomEventScanDone);
+        return true;
+    }
+    // one redraw at a time; lines arriving meanwhile are picked up by it
+    if (!scan_update_pending)
     {
-        size_t ssid_length = strlen(current_position);
+        scan_update_pending = true;
+        view_dispatcher_send_custom_event(app->view_dispatcher, FlipWiFiCustomEventScanUpdated);
+    }
+    return done;
+}
 
-        // Trim leading and trailing whitespace
-        size_t trimmed_length = ssid_length;
-        char *trim_start = trim_whitespace(current_position, &trimmed_length);
+// Function called when the scan request completes (UART worker thread); a request that
+// ends before the parser saw the end of the reply leaves the scan incomplete
+static void flip_wifi_scan_complete(uint32_t request_id, bool success, const char *response, void *context)
+{
+    UNUSED(success);
+    UNUSED(response);
+    FlipWiFiApp *app = (FlipWiFiApp *)context;
+    if (request_id == scan_request_id && !scan_reply_done)
+    {
+        view_dispatcher_send_custom_event(app->view_dispatcher, FlipWiFiCustomEventScanFailed);
+    }
+}
 
-        // Handle empty SSIDs
-        if (trimmed_length > 0)
-        {
-            ssid_list[ssid_count] = malloc(trimmed_length + 1);
-            if (ssid_list[ssid_count] == NULL)
-            {
-                FURI_LOG_E(TAG, "Memory allocation failed for the last SSID");
-                easy_flipper_dialog("[ERROR]", "Memory allocation failed for the last SSID");
-                return false;
-            }
-            strncpy(ssid_list[ssid_count], trim_start, trimmed_length);
-            ssid_list[ssid_count][trimmed_length] = '\0'; // Null-terminate the string
-            ssid_count++;
-        }
+// Function to start a scan; networks show up in the submenu as they arrive.
+// Recent results stay listed and are refreshed in place instead of starting empty.
+static bool flip_wifi_begin_scan(FlipWiFiApp *app)
+{
+    flip_wifi_cancel_scan();
+    if (!flip_wifi_alloc_scan(app))
+    {
+        return false;
     }
+    furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+    if (flip_wifi_scan_is_fresh())
+    {
+        flip_wifi_scan_refresh(&wifi_scan);
+    }
+    else
+    {
+        flip_wifi_scan_begin(&wifi_scan, wifi_scan.records, wifi_scan.capacity);
+    }
+    furi_mutex_release(app->scan_mutex);
+
+    scan_update_pending = false;
+    scan_reply_done = false;
+    flipper_http_set_line_callback(flip_wifi_scan_line, app);
+    scan_request_id = flipper_http_enqueue("[WIFI/SCAN]", flip_wifi_scan_complete, app);
+    if (scan_request_id == 0)
+    {
+        flipper_http_set_line_callback(NULL, NULL);
+        return false;
+    }
+    return true;
+}
 
-    // Add each SSID as a submenu item
+// Function to rebuild the scan submenu from the records, keeping the cursor on its network
+static void flip_wifi_redraw_submenu_scan(FlipWiFiApp *app)
+{
+    uint32_t selected = submenu_get_selected_item(app->submenu_wifi);
     submenu_reset(app->submenu_wifi);
-    submenu_set_header(app->submenu_wifi, "WiFi Nearby");
-    for (uint32_t i = 0; i < ssid_count; i++)
+    furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+    char header[32];
+    if (scan_request_id != 0)
     {
-        char *ssid_item = ssid_list[i];
-        if (ssid_item == NULL)
+        snprintf(header, sizeof(header), wifi_scan.refreshing ? "Refreshing... (%zu)" : "Scanning... (%zu)", wifi_scan.count);
+    }
+    else
+    {
+        snprintf(header, sizeof(header), "WiFi Nearby (%zu)", wifi_scan.count);
+    }
+    submenu_set_header(app->submenu_wifi, header);
+    // strongest first; the item index is the record's stable id
+    for (size_t i = 0; i < wifi_scan.count; i++)
+    {
+        submenu_add_item(app->submenu_wifi, wifi_scan.records[i].ssid, FlipWiFiSubmenuIndexWiFiScanStart + wifi_scan.records[i].id, callback_submenu_choices, app);
+    }
+    furi_mutex_release(app->scan_mutex);
+    submenu_set_selected_item(app->submenu_wifi, selected);
+}
+
+bool callback_custom_event(void *context, uint32_t event)
+{
+    FlipWiFiApp *app = (FlipWiFiApp *)context;
+    if (!app)
+    {
+        FURI_LOG_E(TAG, "FlipWiFiApp is NULL");
+        return false;
+    }
+    switch (event)
+    {
+    case FlipWiFiCustomEventScanUpdated:
+        scan_update_pending = false;
+        if (scan_request_id != 0 && app->submenu_wifi)
         {
-            // skip any NULL entries
-            continue;
+            flip_wifi_redraw_submenu_scan(app);
         }
-        char ssid[64];
-        snprintf(ssid, sizeof(ssid), "%s", ssid_item);
-        submenu_add_item(app->submenu_wifi, ssid, FlipWiFiSubmenuIndexWiFiScanStart + i, callback_submenu_choices, app);
+        return true;
+    case FlipWiFiCustomEventScanDone:
+    case FlipWiFiCustomEventScanFailed:
+        if (scan_request_id == 0)
+        {
+            return true; // cancelled
+        }
+        flipper_http_set_line_callback(NULL, NULL);
+        scan_request_id = 0;
+        furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+        flip_wifi_scan_end(&wifi_scan, event == FlipWiFiCustomEventScanDone);
+        size_t count = wifi_scan.count;
+        furi_mutex_release(app->scan_mutex);
+        if (event == FlipWiFiCustomEventScanDone)
+        {
+            flip_wifi_save_scan(app);
+        }
+        if (app->submenu_wifi)
+        {
+            flip_wifi_redraw_submenu_scan(app);
+        }
+        if (event == FlipWiFiCustomEventScanFailed && count == 0)
+        {
+            easy_flipper_dialog("[ERROR]", "WiFi scan failed.\nCheck the WiFi Dev Board.");
+            view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewSubmenuMain);
+        }
+        return true;
+    case FlipWiFiCustomEventProbeDone:
+        flip_wifi_probe_wait(app);
+        submenu_set_header(app->submenu_main, probe_found ? "FlipWiFi (online)" : "FlipWiFi (no board)");
+        return true;
+    default:
+        return false;
     }
-    furi_string_free(scan_data);
-    return true;
 }
+
 void callback_submenu_choices(void *context, uint32_t index)
 {
     FlipWiFiApp *app = (FlipWiFiApp *)context;
@@ -759,37 +1164,29 @@ void callback_submenu_choices(void *context, uint32_t index)
     switch (index)
     {
     case FlipWiFiSubmenuIndexWiFiScan:
-        flip_wifi_free_all(app);
+        flip_wifi_leave_screen();
         if (!flip_wifi_alloc_submenus(app, FlipWiFiViewSubmenuScan))
         {
             easy_flipper_dialog("[ERROR]", "Failed to allocate submenus for WiFi Scan");
             return;
         }
-        // initialize uart
-        if (!flipper_http_init(flipper_http_rx_callback, app))
+        // reuse the uart session (reconnects if the port was lost)
+        if (!flip_wifi_session_ensure(app))
         {
             easy_flipper_dialog("[ERROR]", "Failed to initialize flipper http");
             return;
         }
-        bool _flip_wifi_handle_scan()
+        if (!flip_wifi_begin_scan(app))
         {
-            return flip_wifi_handle_scan(app);
+            easy_flipper_dialog("[ERROR]", "Failed to start\nthe WiFi scan.");
+            return;
         }
-        Storage *storage = furi_record_open(RECORD_STORAGE);
-        // ensure flip_wifi directory is there
-        char directory_path[128];
-        snprintf(directory_path, sizeof(directory_path), STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi");
-        storage_common_mkdir(storage, directory_path);
-        // ensure directory is there for saving data
-        snprintf(directory_path, sizeof(directory_path), STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data");
-        storage_common_mkdir(storage, directory_path);
-        furi_record_close(RECORD_STORAGE);
-        // scan for wifi ad parse the results
-        flipper_http_loading_task(flipper_http_scan_wifi, _flip_wifi_handle_scan, FlipWiFiViewSubmenu, FlipWiFiViewSubmenuMain, &app->view_dispatcher);
-        flipper_http_deinit();
+        // show the list right away (empty, or the recent results); Back cancels the scan
+        flip_wifi_redraw_submenu_scan(app);
+        view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewSubmenu);
         break;
     case FlipWiFiSubmenuIndexWiFiSaved:
-        flip_wifi_free_all(app);
+        flip_wifi_leave_screen();
         if (!flip_wifi_alloc_submenus(app, FlipWiFiViewSubmenuSaved))
         {
             FURI_LOG_E(TAG, "Failed to allocate submenus for WiFi Saved");
@@ -798,7 +1195,7 @@ void callback_submenu_choices(void *context, uint32_t index)
         view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewSubmenu);
         break;
     case FlipWiFiSubmenuIndexAbout:
-        flip_wifi_free_all(app);
+        flip_wifi_leave_screen();
         if (!flip_wifi_alloc_widgets(app, FlipWiFiViewAbout))
         {
             FURI_LOG_E(TAG, "Failed to allocate widget for About");
@@ -806,8 +1203,66 @@ void callback_submenu_choices(void *context, uint32_t index)
         }
         view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewAbout);
         break;
+    case FlipWiFiSubmenuIndexDiagnostics:
+        flip_wifi_leave_screen();
+        if (!flip_wifi_alloc_widgets(app, FlipWiFiViewDiagnostics))
+        {
+            FURI_LOG_E(TAG, "Failed to allocate widget for Diagnostics");
+            return;
+        }
+        view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewDiagnostics);
+        break;
+#if FLIPPER_HTTP_REPLAY
+    case FlipWiFiSubmenuIndexCapture:
+        if (!flip_wifi_session_ensure(app))
+        {
+            easy_flipper_dialog("[ERROR]", "Failed to initialize flipper http");
+            return;
+        }
+        if (replay_capturing)
+        {
+            flipper_http_capture(NULL);
+            replay_capturing = false;
+        }
+        else
+        {
+            replay_capturing = flipper_http_capture(FLIP_WIFI_REPLAY_PATH);
+        }
+        submenu_change_item_label(app->submenu_main, FlipWiFiSubmenuIndexCapture, replay_capturing ? "Capture: ON" : "Capture: OFF");
+        break;
+    case FlipWiFiSubmenuIndexReplay:
+        flip_wifi_leave_screen();
+        if (!flip_wifi_session_ensure(app) || !flip_wifi_alloc_scan(app))
+        {
+            easy_flipper_dialog("[ERROR]", "Failed to initialize flipper http");
+            return;
+        }
+        // scan replies go through the scan parser, other responses through the request path
+        furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+        flip_wifi_scan_begin(&wifi_scan, wifi_scan.records, wifi_scan.capacity);
+        furi_mutex_release(app->scan_mutex);
+        flipper_http_set_line_callback(flip_wifi_scan_line, app);
+        replay_ran = flipper_http_replay(FLIP_WIFI_REPLAY_PATH, FLIP_WIFI_REPLAY_RATE, NULL, &replay_report);
+        flipper_http_set_line_callback(NULL, NULL);
+        furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+        flip_wifi_scan_end(&wifi_scan, true);
+        replay_networks = wifi_scan.count;
+        furi_mutex_release(app->scan_mutex);
+        scan_timestamp = 0; // the next Scan starts fresh
+        if (!replay_ran)
+        {
+            easy_flipper_dialog("[ERROR]", "Failed to replay\nreplay.txt");
+            return;
+        }
+        if (!flip_wifi_alloc_widgets(app, FlipWiFiViewDiagnostics))
+        {
+            FURI_LOG_E(TAG, "Failed to allocate widget for Diagnostics");
+            return;
+        }
+        view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewDiagnostics);
+        break;
+#endif
     case FlipWiFiSubmenuIndexWiFiSavedAddSSID:
-        flip_wifi_free_text_inputs(app);
         if (!flip_wifi_alloc_text_inputs(app, FlipWiFiViewTextInputSavedAddSSID))
         {
             FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved Add Password");
@@ -815,8 +1270,11 @@ void callback_submenu_choices(void *context, uint32_t index)
         }
         view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewTextInput);
         break;
+    case FlipWiFiSubmenuIndexWiFiSavedConnectBest:
+        flip_wifi_connect_best_known(app);
+        break;
     case FlipWiFiSubmenuIndexCommands:
-        flip_wifi_free_all(app);
+        flip_wifi_leave_screen();
         if (!flip_wifi_alloc_submenus(app, FlipWiFiViewSubmenuCommands))
         {
             FURI_LOG_E(TAG, "Failed to allocate submenus for Commands");
@@ -824,19 +1282,23 @@ void callback_submenu_choices(void *context, uint32_t index)
         }
         view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewSubmenu);
         break;
+    case FlipWiFiSubmenuIndexSettingsCompat:
+        settings_compat_set(!settings_compat_enabled());
+        submenu_change_item_label(app->submenu_main, FlipWiFiSubmenuIndexSettingsCompat, settings_compat_enabled() ? "App Copies: ON" : "App Copies: OFF");
+        break;
     case FlipWiFiSubmenuIndexFastCommandStart ... FlipWiFiSubmenuIndexFastCommandStart + 4:
-        // initialize uart
-        if (!flipper_http_init(flipper_http_rx_callback, app))
+        // reuse the uart session (reconnects if the port was lost)
+        if (!flip_wifi_session_ensure(app))
         {
             easy_flipper_dialog("[ERROR]", "Failed to initialize flipper http");
             return;
         }
         // Handle fast commands
+        bool sent = false;
         switch (index)
         {
         case FlipWiFiSubmenuIndexFastCommandStart + 0:
             // CUSTOM - send to text input and return
-            flip_wifi_free_text_inputs(app);
             if (!flip_wifi_alloc_text_inputs(app, FlipWiFiSubmenuIndexFastCommandStart))
             {
                 FURI_LOG_E(TAG, "Failed to allocate text input for Fast Command");
@@ -846,39 +1308,43 @@ void callback_submenu_choices(void *context, uint32_t index)
             return;
         case FlipWiFiSubmenuIndexFastCommandStart + 1:
             // PING
-            flipper_http_ping();
+            sent = flipper_http_ping();
             break;
         case FlipWiFiSubmenuIndexFastCommandStart + 2:
             // LIST
-            flipper_http_list_commands();
+            sent = flipper_http_list_commands();
             break;
         case FlipWiFiSubmenuIndexFastCommandStart + 3:
             // IP/ADDRESS
-            flipper_http_ip_address();
+            sent = flipper_http_ip_address();
             break;
         case FlipWiFiSubmenuIndexFastCommandStart + 4:
             // WIFI/IP
-            flipper_http_ip_wifi();
+            sent = flipper_http_ip_wifi();
             break;
         default:
             break;
         }
-        while (fhttp.last_response == NULL || strlen(fhttp.last_response) == 0)
+        if (sent)
         {
-            // Wait for the response
-            furi_delay_ms(100);
+            flip_wifi_show_response();
         }
-        if (fhttp.last_response != NULL)
-        {
-            char response[100];
-            snprintf(response, sizeof(response), "%s", fhttp.last_response);
-            easy_flipper_dialog("", response);
-        }
-        flipper_http_deinit();
         break;
-    case 100 ... 199:
+    case FlipWiFiSubmenuIndexWiFiScanStart ... FlipWiFiSubmenuIndexWiFiScanStart + MAX_SCAN_NETWORKS - 1:
+    {
+        // item indices are stable record ids, the records themselves move while a scan runs
         ssid_index = index - FlipWiFiSubmenuIndexWiFiScanStart;
-        flip_wifi_free_views(app);
+        furi_mutex_acquire(app->scan_mutex, FuriWaitForever);
+        const FlipWiFiScanRecord *record = flip_wifi_scan_find(&wifi_scan, ssid_index);
+        if (record)
+        {
+            scan_selected = *record;
+        }
+        furi_mutex_release(app->scan_mutex);
+        if (!record)
+        {
+            return;
+        }
         if (!flip_wifi_alloc_views(app, FlipWiFiViewWiFiScan))
         {
             FURI_LOG_E(TAG, "Failed to allocate views for WiFi Scan");
@@ -886,11 +1352,15 @@ void callback_submenu_choices(void *context, uint32_t index)
         }
         view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewGeneric);
         break;
-    case 200 ... 299:
+    }
+    case FlipWiFiSubmenuIndexWiFiSavedStart ... FlipWiFiSubmenuIndexWiFiSavedStart + FLIP_WIFI_CREDENTIALS_NONE - 1:
         ssid_index = index - FlipWiFiSubmenuIndexWiFiSavedStart;
-        flip_wifi_free_views(app);
-        snprintf(current_ssid, sizeof(current_ssid), "%s", wifi_playlist->ssids[ssid_index]);
-        snprintf(current_password, sizeof(current_password), "%s", wifi_playlist->passwords[ssid_index]);
+        // the password is only read from storage for the network being opened
+        if (!playlist_load_record(ssid_index, current_ssid, sizeof(current_ssid), current_password, sizeof(current_password)))
+        {
+            easy_flipper_dialog("[ERROR]", "Failed to load the\nsaved network.");
+            return;
+        }
         if (!flip_wifi_alloc_views(app, FlipWiFiViewWiFiSaved))
         {
             FURI_LOG_E(TAG, "Failed to allocate views for WiFi Saved");
@@ -923,28 +1393,28 @@ void flip_wifi_text_updated_password_scan(void *context)
         return;
     }
 
-    // Ensure ssid_index is valid
-    if (ssid_index >= MAX_SCAN_NETWORKS)
+    // Ensure a scanned network was picked
+    if (scan_selected.ssid[0] == '\0')
     {
-        FURI_LOG_E(TAG, "Invalid ssid_index: %ld", ssid_index);
+        FURI_LOG_E(TAG, "No scanned network selected");
         return;
     }
 
-    // Check if there's space in the playlist
-    if (wifi_playlist->count >= MAX_SAVED_NETWORKS)
+    // the saved list replaces the scan list below
+    flip_wifi_cancel_scan();
+
+    const char *ssid = scan_selected.ssid;
+    FURI_LOG_I(TAG, "Adding SSID: %s", ssid);
+    FURI_LOG_I(TAG, "Count: %d", wifi_playlist->count);
+    // Add the SSID to the playlist (fails once the heap reserve is reached)
+    if (!playlist_add(wifi_playlist, ssid))
     {
-        FURI_LOG_E(TAG, "Playlist is full. Cannot add more entries.");
+        easy_flipper_dialog("[ERROR]", "Playlist is full.\nDelete a network first.");
         return;
     }
-    FURI_LOG_I(TAG, "Adding SSID: %s", ssid_list[ssid_index]);
-    FURI_LOG_I(TAG, "Count: %d", wifi_playlist->count);
-    // Add the SSID and password to the playlist
-    snprintf(wifi_playlist->ssids[wifi_playlist->count], MAX_SSID_LENGTH, "%s", ssid_list[ssid_index]);
-    snprintf(wifi_playlist->passwords[wifi_playlist->count], MAX_SSID_LENGTH, "%s", app->uart_text_input_buffer);
-    wifi_playlist->count++;
 
-    // Save the updated playlist to storage
-    save_playlist(wifi_playlist);
+    // Append the new record to storage
+    playlist_append_record(ssid, app->uart_text_input_buffer);
 
     // Redraw the submenu to reflect changes
     flip_wifi_redraw_submenu_saved(app);
@@ -968,11 +1438,11 @@ void flip_wifi_text_updated_password_saved(void *context)
     // Ensure null-termination
     app->uart_text_input_buffer[app->uart_text_input_buffer_size - 1] = '\0';
 
-    // update the password_saved in the playlist
-    snprintf(wifi_playlist->passwords[ssid_index], MAX_SSID_LENGTH, app->uart_text_input_buffer);
+    // update the password of the opened network
+    snprintf(current_password, sizeof(current_password), "%s", app->uart_text_input_buffer);
 
-    // save the playlist to storage
-    save_playlist(wifi_playlist);
+    // rewrite just this record in storage
+    playlist_update_record(ssid_index, current_ssid, current_password);
 
     // switch to back to the saved view
     view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewSubmenu);
@@ -1001,14 +1471,12 @@ void flip_wifi_text_updated_add_ssid(void *context)
     app->uart_text_input_buffer[app->uart_text_input_buffer_size - 1] = '\0';
     save_char("wifi-ssid", app->uart_text_input_buffer);
     view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewSubmenuMain);
-    uart_text_input_reset(app->uart_text_input);
-    uart_text_input_set_header_text(app->uart_text_input, "Enter Password");
-    app->uart_text_input_buffer_size = MAX_SSID_LENGTH;
-    free(app->uart_text_input_buffer);
-    free(app->uart_text_input_temp_buffer);
-    easy_flipper_set_buffer(&app->uart_text_input_buffer, app->uart_text_input_buffer_size);
-    easy_flipper_set_buffer(&app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size);
-    uart_text_input_set_result_callback(app->uart_text_input, flip_wifi_text_updated_add_password, app, app->uart_text_input_temp_buffer, app->uart_text_input_buffer_size, false);
+    // the same text input asks for the password next
+    if (!flip_wifi_alloc_text_inputs(app, FlipWiFiViewTextInputSavedAddPassword))
+    {
+        FURI_LOG_E(TAG, "Failed to allocate text input for WiFi Saved Add Password");
+        return;
+    }
     view_dispatcher_switch_to_view(app->view_dispatcher, FlipWiFiViewTextInput);
 }
 void flip_wifi_text_updated_add_password(void *context)
@@ -1043,13 +1511,15 @@ void flip_wifi_text_updated_add_password(void *context)
         return;
     }
 
-    // add the SSID and password_scan to the playlist
-    snprintf(wifi_playlist->ssids[wifi_playlist->count], MAX_SSID_LENGTH, wifi_ssid);
-    snprintf(wifi_playlist->passwords[wifi_playlist->count], MAX_SSID_LENGTH, app->uart_text_input_buffer);
-    wifi_playlist->count++;
+    // add the SSID to the playlist (fails once the heap reserve is reached)
+    if (!playlist_add(wifi_playlist, wifi_ssid))
+    {
+        easy_flipper_dialog("[ERROR]", "Playlist is full.\nDelete a network first.");
+        return;
+    }
 
-    // save the playlist to storage
-    save_playlist(wifi_playlist);
+    // append the new record to storage
+    playlist_append_record(wifi_ssid, app->uart_text_input_buffer);
 
     flip_wifi_redraw_submenu_saved(app);
 
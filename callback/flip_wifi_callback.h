@@ -1,8 +1,12 @@
 #pragma once
 #include <flip_wifi.h>
 #include <flip_storage/flip_wifi_storage.h>
+#include <scan/flip_wifi_scan.h>
 #include <flip_wifi_icons.h>
 
 void flip_wifi_free_all(void *context);
+void flip_wifi_free_scan(void *context);
+bool flip_wifi_probe_start(void *context);
 uint32_t callback_exit_app(void *context);
-void callback_submenu_choices(void *context, uint32_t index);
\ No newline at end of file
+void callback_submenu_choices(void *context, uint32_t index);
+bool callback_custom_event(void *context, uint32_t event);
\ No newline at end of file
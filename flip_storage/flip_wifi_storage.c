@@ -1,6 +1,7 @@
 #include <flip_storage/flip_wifi_storage.h>
 
-static char *app_ids[8] = {
+// used when apps_data/flip_wifi/data/apps.txt is missing
+static const char *const default_app_ids[] = {
     "flip_wifi",
     "flip_store",
     "flip_social",
@@ -10,323 +11,941 @@ static char *app_ids[8] = {
     "web_crawler",
     "flip_world"};
 
-// Function to save the playlist
-void save_playlist(WiFiPlaylist *playlist)
+// Function to grow a playlist buffer to hold at least needed items
+static bool playlist_grow(void **buffer, size_t *capacity, size_t needed, size_t item_size, size_t initial)
 {
-    if (!playlist)
+    if (needed <= *capacity)
     {
-        FURI_LOG_E(TAG, "Playlist is NULL");
-        return;
+        return true;
     }
-
-    // Create the directory for saving settings
-    char directory_path[128];
-    snprintf(directory_path, sizeof(directory_path), STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi");
-
-    // Open storage
-    Storage *storage = furi_record_open(RECORD_STORAGE);
-    if (!storage)
+    size_t grown = *capacity ? *capacity * 2 : initial;
+    while (grown < needed)
     {
-        FURI_LOG_E(TAG, "Failed to open storage record");
-        return;
+        grown *= 2;
     }
+    // malloc does not fail gracefully on the Flipper, so stop while there is headroom
+    if (memmgr_get_free_heap() < (grown - *capacity) * item_size + FLIP_WIFI_PLAYLIST_HEAP_RESERVE)
+    {
+        FURI_LOG_E(TAG, "Not enough free heap to grow the playlist");
+        return false;
+    }
+    void *resized = realloc(*buffer, grown * item_size);
+    if (!resized)
+    {
+        return false;
+    }
+    *buffer = resized;
+    *capacity = grown;
+    return true;
+}
 
-    // Create the directory
-    storage_common_mkdir(storage, directory_path);
-    snprintf(directory_path, sizeof(directory_path), STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data");
-    storage_common_mkdir(storage, directory_path);
+void playlist_reset(WiFiPlaylist *playlist)
+{
+    playlist->count = 0;
+    playlist->pool_size = 0;
+}
 
-    // Open the settings file
-    File *file = storage_file_alloc(storage);
-    if (!file)
+void playlist_release(WiFiPlaylist *playlist)
+{
+    free(playlist->pool);
+    free(playlist->entries);
+    memset(playlist, 0, sizeof(WiFiPlaylist));
+}
+
+bool playlist_add(WiFiPlaylist *playlist, const char *ssid)
+{
+    size_t length = strnlen(ssid, MAX_SSID_NAME_LENGTH - 1);
+    // offsets are 16-bit and the store counts with 16 bits as well
+    if (playlist->count >= FLIP_WIFI_CREDENTIALS_NONE || playlist->pool_size + length + 1 > UINT16_MAX)
     {
-        FURI_LOG_E(TAG, "Failed to allocate file handle");
-        furi_record_close(RECORD_STORAGE);
-        return;
+        return false;
     }
-    if (!storage_file_open(file, WIFI_SSID_LIST_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS))
+    if (!playlist_grow((void **)&playlist->entries, &playlist->capacity, playlist->count + 1, sizeof(WiFiPlaylistEntry), 8) ||
+        !playlist_grow((void **)&playlist->pool, &playlist->pool_capacity, playlist->pool_size + length + 1, 1, 128))
     {
-        FURI_LOG_E(TAG, "Failed to open settings file for writing: %s", WIFI_SSID_LIST_PATH);
-        storage_file_free(file);
-        furi_record_close(RECORD_STORAGE);
-        return;
+        return false;
     }
+    WiFiPlaylistEntry *entry = &playlist->entries[playlist->count++];
+    entry->offset = playlist->pool_size;
+    entry->length = length;
+    memcpy(playlist->pool + entry->offset, ssid, length);
+    playlist->pool[entry->offset + length] = '\0';
+    playlist->pool_size += length + 1;
+    return true;
+}
 
-    FuriString *json_result = furi_string_alloc();
-    if (!json_result)
+void playlist_remove(WiFiPlaylist *playlist, size_t index)
+{
+    if (index >= playlist->count)
     {
-        FURI_LOG_E(TAG, "Failed to allocate FuriString");
-        storage_file_close(file);
-        storage_file_free(file);
-        furi_record_close(RECORD_STORAGE);
         return;
     }
-    furi_string_cat(json_result, "{\"ssids\":[\n");
+    // close the gap in the pool and pull the later offsets back by the same amount
+    size_t offset = playlist->entries[index].offset;
+    size_t removed = playlist->entries[index].length + 1;
+    memmove(playlist->pool + offset, playlist->pool + offset + removed, playlist->pool_size - offset - removed);
+    playlist->pool_size -= removed;
+    memmove(&playlist->entries[index], &playlist->entries[index + 1], (playlist->count - index - 1) * sizeof(WiFiPlaylistEntry));
+    playlist->count--;
     for (size_t i = 0; i < playlist->count; i++)
     {
-        furi_string_cat_printf(json_result, "{\"ssid\":\"%s\",\"password\":\"%s\"}", playlist->ssids[i], playlist->passwords[i]);
-        if (i < playlist->count - 1)
+        if (playlist->entries[i].offset > offset)
         {
-            furi_string_cat(json_result, ",\n");
+            playlist->entries[i].offset -= removed;
         }
     }
-    furi_string_cat(json_result, "\n]}");
-    size_t json_length = furi_string_size(json_result);
-    if (storage_file_write(file, furi_string_get_cstr(json_result), json_length) != json_length)
+}
+
+const char *playlist_ssid(const WiFiPlaylist *playlist, size_t index)
+{
+    return index < playlist->count ? playlist->pool + playlist->entries[index].offset : "";
+}
+
+// set whenever the store changes; wifi_list.txt is re-exported from it on exit
+static bool playlist_json_dirty = false;
+
+// Function to read the header of the shared credentials store
+static bool read_credentials_header(File *file, FlipWiFiCredentialsHeader *header)
+{
+    if (!storage_file_seek(file, 0, true) ||
+        storage_file_read(file, header, sizeof(FlipWiFiCredentialsHeader)) != sizeof(FlipWiFiCredentialsHeader))
+    {
+        return false;
+    }
+    if (header->magic != FLIP_WIFI_CREDENTIALS_MAGIC || header->version != FLIP_WIFI_CREDENTIALS_VERSION ||
+        header->record_size < sizeof(FlipWiFiCredentialsRecord))
     {
-        FURI_LOG_E(TAG, "Failed to write playlist to file");
+        FURI_LOG_E(TAG, "Unsupported credentials file");
+        return false;
     }
-    furi_string_free(json_result);
-    storage_file_close(file);
-    storage_file_free(file);
-    furi_record_close(RECORD_STORAGE);
+    return true;
 }
 
-bool load_playlist(WiFiPlaylist *playlist)
+// Function to write the header of the shared credentials store
+static bool write_credentials_header(File *file, const FlipWiFiCredentialsHeader *header)
 {
-    if (!playlist)
+    return storage_file_seek(file, 0, true) &&
+           storage_file_write(file, header, sizeof(FlipWiFiCredentialsHeader)) == sizeof(FlipWiFiCredentialsHeader);
+}
+
+// Function to read a single record; index is not checked against the header count
+static bool read_credentials_record(File *file, const FlipWiFiCredentialsHeader *header, size_t index, FlipWiFiCredentialsRecord *record)
+{
+    if (!storage_file_seek(file, sizeof(FlipWiFiCredentialsHeader) + (uint32_t)index * header->record_size, true) ||
+        storage_file_read(file, record, sizeof(FlipWiFiCredentialsRecord)) != sizeof(FlipWiFiCredentialsRecord))
     {
-        FURI_LOG_E(TAG, "Playlist is NULL");
         return false;
     }
+    record->ssid[MAX_SSID_LENGTH - 1] = '\0';
+    record->password[MAX_SSID_LENGTH - 1] = '\0';
+    return true;
+}
+
+// Function to write a single record in place
+static bool write_credentials_record(File *file, const FlipWiFiCredentialsHeader *header, size_t index, const char *ssid, const char *password)
+{
+    // zero-padded so no stale stack bytes end up on disk
+    FlipWiFiCredentialsRecord record;
+    memset(&record, 0, sizeof(record));
+    strncpy(record.ssid, ssid, MAX_SSID_LENGTH - 1);
+    strncpy(record.password, password, MAX_SSID_LENGTH - 1);
+    return storage_file_seek(file, sizeof(FlipWiFiCredentialsHeader) + (uint32_t)index * header->record_size, true) &&
+           storage_file_write(file, &record, sizeof(record)) == sizeof(record);
+}
 
-    FuriString *json_result = flipper_http_load_from_file(WIFI_SSID_LIST_PATH);
-    if (!json_result)
+// Function to open the credentials store and validate its header
+static File *open_credentials(Storage *storage, FS_AccessMode access, FlipWiFiCredentialsHeader *header)
+{
+    File *file = storage_file_alloc(storage);
+    if (!storage_file_open(file, FLIP_WIFI_CREDENTIALS_PATH, access, FSOM_OPEN_EXISTING))
     {
-        FURI_LOG_E(TAG, "Failed to load playlist from file");
-        return false;
+        storage_file_free(file);
+        return NULL;
+    }
+    if (!read_credentials_header(file, header))
+    {
+        storage_file_close(file);
+        storage_file_free(file);
+        return NULL;
     }
+    return file;
+}
 
-    // Initialize playlist count
-    playlist->count = 0;
+// Function to close a file returned by open_credentials
+static void close_credentials(File *file)
+{
+    storage_file_close(file);
+    storage_file_free(file);
+}
+
+// Function to create an empty store and keep it open for appending records
+static File *create_credentials(Storage *storage, FlipWiFiCredentialsHeader *header, uint32_t json_hash)
+{
+    header->magic = FLIP_WIFI_CREDENTIALS_MAGIC;
+    header->version = FLIP_WIFI_CREDENTIALS_VERSION;
+    header->record_size = sizeof(FlipWiFiCredentialsRecord);
+    header->count = 0;
+    header->active_index = FLIP_WIFI_CREDENTIALS_NONE;
+    header->json_hash = json_hash;
+
+    storage_common_mkdir(storage, STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi");
+    storage_common_mkdir(storage, STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data");
+    File *file = storage_file_alloc(storage);
+    if (!storage_file_open(file, FLIP_WIFI_CREDENTIALS_PATH, FSAM_READ_WRITE, FSOM_CREATE_ALWAYS))
+    {
+        FURI_LOG_E(TAG, "Failed to open credentials file for writing: %s", FLIP_WIFI_CREDENTIALS_PATH);
+        storage_file_free(file);
+        return NULL;
+    }
+    if (!write_credentials_header(file, header))
+    {
+        FURI_LOG_E(TAG, "Failed to write credentials file");
+        close_credentials(file);
+        return NULL;
+    }
+    return file;
+}
 
-    // Parse the JSON result
-    for (size_t i = 0; i < MAX_SAVED_NETWORKS; i++)
+bool load_active_credentials(char *ssid, size_t ssid_size, char *password, size_t password_size)
+{
+    if (!ssid || !password || ssid_size == 0 || password_size == 0)
     {
-        FuriString *json_data = get_json_array_value_furi("ssids", i, json_result);
-        if (!json_data)
+        return false;
+    }
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FlipWiFiCredentialsHeader header;
+    FlipWiFiCredentialsRecord record;
+    bool loaded = false;
+    File *file = open_credentials(storage, FSAM_READ, &header);
+    if (file)
+    {
+        if (header.active_index < header.count && read_credentials_record(file, &header, header.active_index, &record))
         {
-            break;
+            snprintf(ssid, ssid_size, "%s", record.ssid);
+            snprintf(password, password_size, "%s", record.password);
+            loaded = true;
         }
-        FuriString *ssid = get_json_value_furi("ssid", json_data);
-        FuriString *password = get_json_value_furi("password", json_data);
-        if (!ssid || !password)
+        close_credentials(file);
+    }
+    furi_record_close(RECORD_STORAGE);
+    return loaded;
+}
+
+bool playlist_load_record(size_t index, char *ssid, size_t ssid_size, char *password, size_t password_size)
+{
+    if (!ssid || !password || ssid_size == 0 || password_size == 0)
+    {
+        return false;
+    }
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FlipWiFiCredentialsHeader header;
+    FlipWiFiCredentialsRecord record;
+    bool loaded = false;
+    File *file = open_credentials(storage, FSAM_READ, &header);
+    if (file)
+    {
+        if (index < header.count && read_credentials_record(file, &header, index, &record))
         {
-            FURI_LOG_E(TAG, "Failed to get SSID or Password from JSON");
-            furi_string_free(json_data);
-            break;
+            snprintf(ssid, ssid_size, "%s", record.ssid);
+            snprintf(password, password_size, "%s", record.password);
+            loaded = true;
         }
-        snprintf(playlist->ssids[i], MAX_SSID_LENGTH, "%s", furi_string_get_cstr(ssid));
-        snprintf(playlist->passwords[i], MAX_SSID_LENGTH, "%s", furi_string_get_cstr(password));
-        playlist->count++;
-        furi_string_free(json_data);
-        furi_string_free(ssid);
-        furi_string_free(password);
+        close_credentials(file);
     }
-    furi_string_free(json_result);
-    return true;
+    if (!loaded)
+    {
+        FURI_LOG_E(TAG, "Failed to load saved network %zu", index);
+    }
+    furi_record_close(RECORD_STORAGE);
+    return loaded;
 }
 
-void save_settings(const char *ssid, const char *password)
+bool playlist_set_active(size_t index)
 {
-    char edited_directory_path[128];
-    char edited_file_path[128];
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FlipWiFiCredentialsHeader header;
+    bool saved = false;
+    File *file = open_credentials(storage, FSAM_READ_WRITE, &header);
+    if (file)
+    {
+        if (index < header.count)
+        {
+            header.active_index = index;
+            saved = write_credentials_header(file, &header);
+        }
+        close_credentials(file);
+    }
+    furi_record_close(RECORD_STORAGE);
+    return saved;
+}
 
-    for (size_t i = 0; i < 8; i++)
+bool playlist_update_record(size_t index, const char *ssid, const char *password)
+{
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FlipWiFiCredentialsHeader header;
+    bool saved = false;
+    File *file = open_credentials(storage, FSAM_READ_WRITE, &header);
+    if (file)
+    {
+        saved = index < header.count && write_credentials_record(file, &header, index, ssid, password);
+        close_credentials(file);
+    }
+    if (!saved)
     {
-        // Construct the directory and file paths for the current app
-        snprintf(edited_directory_path, sizeof(edited_directory_path), STORAGE_EXT_PATH_PREFIX "/apps_data/%s", app_ids[i]);
-        snprintf(edited_file_path, sizeof(edited_file_path), STORAGE_EXT_PATH_PREFIX "/apps_data/%s/settings.bin", app_ids[i]);
+        FURI_LOG_E(TAG, "Failed to update saved network %zu", index);
+    }
+    playlist_json_dirty |= saved;
+    furi_record_close(RECORD_STORAGE);
+    return saved;
+}
 
-        // Open the storage record
-        Storage *storage = furi_record_open(RECORD_STORAGE);
-        if (!storage)
+bool playlist_append_record(const char *ssid, const char *password)
+{
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FlipWiFiCredentialsHeader header;
+    File *file = open_credentials(storage, FSAM_READ_WRITE, &header);
+    if (!file)
+    {
+        // first network: start from an empty store
+        file = create_credentials(storage, &header, 0);
+    }
+    bool saved = false;
+    if (file)
+    {
+        if (header.count < FLIP_WIFI_CREDENTIALS_NONE && write_credentials_record(file, &header, header.count, ssid, password))
         {
-            FURI_LOG_E(TAG, "Failed to open storage record for app: %s", app_ids[i]);
-            continue; // Skip to the next app
+            header.count++;
+            saved = write_credentials_header(file, &header);
         }
+        close_credentials(file);
+    }
+    if (!saved)
+    {
+        FURI_LOG_E(TAG, "Failed to append saved network");
+    }
+    playlist_json_dirty |= saved;
+    furi_record_close(RECORD_STORAGE);
+    return saved;
+}
 
-        // Ensure the directory exists
-        storage_common_mkdir(storage, edited_directory_path);
-
-        // Allocate a file handle
-        File *file = storage_file_alloc(storage);
-        if (!file)
+bool playlist_delete_record(size_t index)
+{
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FlipWiFiCredentialsHeader header;
+    FlipWiFiCredentialsRecord record;
+    bool saved = false;
+    File *file = open_credentials(storage, FSAM_READ_WRITE, &header);
+    if (file)
+    {
+        saved = index < header.count;
+        // move the records behind the deleted one down by one slot
+        for (size_t i = index + 1; saved && i < header.count; i++)
         {
-            FURI_LOG_E(TAG, "Failed to allocate storage file for app: %s", app_ids[i]);
-            furi_record_close(RECORD_STORAGE);
-            continue; // Skip to the next app
+            saved = read_credentials_record(file, &header, i, &record) &&
+                    write_credentials_record(file, &header, i - 1, record.ssid, record.password);
         }
+        if (saved)
+        {
+            header.count--;
+            if (header.active_index == index)
+            {
+                header.active_index = FLIP_WIFI_CREDENTIALS_NONE;
+            }
+            else if (header.active_index != FLIP_WIFI_CREDENTIALS_NONE && header.active_index > index)
+            {
+                header.active_index--;
+            }
+            // drop the now-duplicated last record
+            saved = write_credentials_header(file, &header) &&
+                    storage_file_seek(file, sizeof(header) + (uint32_t)header.count * header.record_size, true) &&
+                    storage_file_truncate(file);
+        }
+        close_credentials(file);
+    }
+    if (!saved)
+    {
+        FURI_LOG_E(TAG, "Failed to delete saved network %zu", index);
+    }
+    playlist_json_dirty |= saved;
+    furi_record_close(RECORD_STORAGE);
+    return saved;
+}
+
+// Function to fold a block of wifi_list.txt into its FNV-1a hash
+static uint32_t playlist_json_hash_step(uint32_t hash, const char *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
-        // Open the file in read mode to read existing data
-        bool file_opened = storage_file_open(file, edited_file_path, FSAM_READ, FSOM_OPEN_EXISTING);
-        size_t file_size = 0;
-        uint8_t *buffer = NULL;
+// Function to hash one block of wifi_list.txt as it is read
+static bool playlist_json_hash_chunk(const uint8_t *data, size_t length, size_t offset, void *context)
+{
+    UNUSED(offset);
+    uint32_t *hash = (uint32_t *)context;
+    *hash = playlist_json_hash_step(*hash, (const char *)data, length);
+    return true;
+}
 
-        if (file_opened)
+// Function to append a string as the contents of a JSON string literal
+static void playlist_json_escape(FuriString *json, const char *text)
+{
+    for (; *text; text++)
+    {
+        unsigned char c = (unsigned char)*text;
+        switch (c)
         {
-            // Get the file size
-            file_size = storage_file_size(file);
-            buffer = malloc(file_size);
-            if (!buffer)
+        case '"':
+            furi_string_cat_str(json, "\\\"");
+            break;
+        case '\\':
+            furi_string_cat_str(json, "\\\\");
+            break;
+        case '\n':
+            furi_string_cat_str(json, "\\n");
+            break;
+        case '\r':
+            furi_string_cat_str(json, "\\r");
+            break;
+        case '\t':
+            furi_string_cat_str(json, "\\t");
+            break;
+        default:
+            if (c < 0x20)
             {
-                FURI_LOG_E(TAG, "Failed to allocate buffer for app: %s", app_ids[i]);
-                storage_file_close(file);
-                storage_file_free(file);
-                furi_record_close(RECORD_STORAGE);
-                continue;
+                furi_string_cat_printf(json, "\\u%04x", c);
             }
-
-            // Read the existing data
-            if (storage_file_read(file, buffer, file_size) != file_size)
+            else
             {
-                FURI_LOG_E(TAG, "Failed to read settings file for app: %s", app_ids[i]);
-                free(buffer);
-                storage_file_close(file);
-                storage_file_free(file);
-                furi_record_close(RECORD_STORAGE);
-                continue;
+                furi_string_push_back(json, (char)c);
             }
+            break;
+        }
+    }
+}
 
-            storage_file_close(file);
+bool export_playlist(void)
+{
+    if (!playlist_json_dirty)
+    {
+        return true;
+    }
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FlipWiFiCredentialsHeader header;
+    FlipWiFiCredentialsRecord record;
+    File *store = open_credentials(storage, FSAM_READ_WRITE, &header);
+    if (!store)
+    {
+        furi_record_close(RECORD_STORAGE);
+        return false;
+    }
+    File *file = storage_file_alloc(storage);
+    if (!storage_file_open(file, WIFI_SSID_LIST_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS))
+    {
+        FURI_LOG_E(TAG, "Failed to open playlist file for writing: %s", WIFI_SSID_LIST_PATH);
+        storage_file_free(file);
+        close_credentials(store);
+        furi_record_close(RECORD_STORAGE);
+        return false;
+    }
+
+    // stream one record at a time so the export never holds the whole list
+    FuriString *json_result = furi_string_alloc_set_str("{\"ssids\":[\n");
+    uint32_t json_hash = 2166136261u;
+    bool saved = true;
+    for (size_t i = 0; saved && i <= header.count; i++)
+    {
+        if (i == header.count)
+        {
+            furi_string_cat(json_result, "\n]}");
+        }
+        else if (read_credentials_record(store, &header, i, &record))
+        {
+            furi_string_cat_str(json_result, i > 0 ? ",\n{\"ssid\":\"" : "{\"ssid\":\"");
+            playlist_json_escape(json_result, record.ssid);
+            furi_string_cat_str(json_result, "\",\"password\":\"");
+            playlist_json_escape(json_result, record.password);
+            furi_string_cat_str(json_result, "\"}");
         }
         else
         {
-            // If the file doesn't exist, initialize an empty buffer
-            file_size = 0;
-            buffer = NULL;
+            saved = false;
+            break;
         }
+        size_t length = furi_string_size(json_result);
+        saved = storage_file_write(file, furi_string_get_cstr(json_result), length) == length;
+        json_hash = playlist_json_hash_step(json_hash, furi_string_get_cstr(json_result), length);
+        furi_string_reset(json_result);
+    }
+    furi_string_free(json_result);
+    storage_file_close(file);
+    storage_file_free(file);
 
-        storage_file_free(file);
+    // remember what was exported so a hand edit is imported next launch
+    if (saved)
+    {
+        header.json_hash = json_hash;
+        saved = write_credentials_header(store, &header);
+        playlist_json_dirty = false;
+    }
+    else
+    {
+        FURI_LOG_E(TAG, "Failed to export playlist to JSON");
+    }
+    close_credentials(store);
+    furi_record_close(RECORD_STORAGE);
+    return saved;
+}
+
+// State of an import from wifi_list.txt, fed value by value from the file blocks
+typedef struct
+{
+    WiFiPlaylist *playlist;
+    const char *active_ssid;
+    File *file;
+    FlipWiFiCredentialsHeader header;
+    FlipWiFiCredentialsRecord record; // network being filled in
+    int index;                        // array index of the network being filled in (-1 if none)
+    bool has_ssid;
+    bool has_password;
+    bool stopped; // the list is full or the store could not be written
+    jsmn_stream_parser json;
+} FlipWiFiImport;
+
+// Function to add the network that was being filled in to the store
+static void import_commit(FlipWiFiImport *import)
+{
+    if (import->index < 0 || import->stopped)
+    {
+        return;
+    }
+    if (!import->has_ssid || !import->has_password)
+    {
+        FURI_LOG_E(TAG, "Failed to get SSID or Password from JSON");
+        return;
+    }
+    FlipWiFiCredentialsRecord *record = &import->record;
+    if (!playlist_add(import->playlist, record->ssid))
+    {
+        FURI_LOG_E(TAG, "Playlist is full, imported %zu networks", import->playlist->count);
+        import->stopped = true;
+        return;
+    }
+    if (!write_credentials_record(import->file, &import->header, import->header.count, record->ssid, record->password))
+    {
+        FURI_LOG_E(TAG, "Failed to write saved network %d", import->index);
+        playlist_remove(import->playlist, import->playlist->count - 1);
+        import->stopped = true;
+        return;
+    }
+    // the active network is matched by SSID since indices may have moved
+    if (import->active_ssid && strcmp(record->ssid, import->active_ssid) == 0)
+    {
+        import->header.active_index = import->header.count;
+    }
+    import->header.count++;
+}
+
+// Function to take one "ssids[n].ssid" or "ssids[n].password" value
+static void import_value(const char *path, const char *value, void *context)
+{
+    FlipWiFiImport *import = (FlipWiFiImport *)context;
+    const char *bracket = strchr(path, '[');
+    const char *key = strrchr(path, '.');
+    if (!bracket || !key)
+    {
+        return;
+    }
+    int index = atoi(bracket + 1);
+    if (index != import->index)
+    {
+        import_commit(import);
+        memset(&import->record, 0, sizeof(import->record));
+        import->index = index;
+        import->has_ssid = false;
+        import->has_password = false;
+    }
+    if (strcmp(key + 1, "ssid") == 0)
+    {
+        snprintf(import->record.ssid, sizeof(import->record.ssid), "%s", value);
+        import->has_ssid = true;
+    }
+    else
+    {
+        snprintf(import->record.password, sizeof(import->record.password), "%s", value);
+        import->has_password = true;
+    }
+}
 
-        // Prepare new SSID and Password
-        size_t new_ssid_length = strlen(ssid) + 1;         // Including null terminator
-        size_t new_password_length = strlen(password) + 1; // Including null terminator
+// Function to feed one block of wifi_list.txt to the parser
+static bool import_chunk(const uint8_t *data, size_t length, size_t offset, void *context)
+{
+    UNUSED(offset);
+    FlipWiFiImport *import = (FlipWiFiImport *)context;
+    jsmn_stream_feed_furi(&import->json, (const char *)data, length);
+    return !import->stopped && import->json.error == 0;
+}
 
-        // Calculate the new file size
-        size_t new_file_size = sizeof(size_t) + new_ssid_length + sizeof(size_t) + new_password_length;
+// Function to import wifi_list.txt into a new store, filling the SSID index as it goes.
+// The file is streamed in blocks so its size does not matter.
+static bool import_playlist(Storage *storage, WiFiPlaylist *playlist, const char *active_ssid, uint32_t json_hash)
+{
+    static const char *const paths[] = {"ssids[*].ssid", "ssids[*].password"};
+    FlipWiFiImport *import = malloc(sizeof(FlipWiFiImport));
+    if (!import)
+    {
+        FURI_LOG_E(TAG, "Failed to allocate playlist import");
+        return false;
+    }
+    memset(import, 0, sizeof(FlipWiFiImport));
+    import->playlist = playlist;
+    import->active_ssid = active_ssid;
+    import->index = -1;
+    import->file = create_credentials(storage, &import->header, json_hash);
+    if (!import->file)
+    {
+        free(import);
+        return false;
+    }
+    jsmn_stream_init_furi(&import->json, paths, COUNT_OF(paths), import_value, import);
 
-        // If there is additional data beyond SSID and Password, preserve it
-        size_t additional_data_size = 0;
-        uint8_t *additional_data = NULL;
+    bool loaded = flipper_http_read_file_chunks(WIFI_SSID_LIST_PATH, 0, import_chunk, import);
+    if (!loaded || import->json.error != 0)
+    {
+        FURI_LOG_E(TAG, "Failed to parse playlist JSON, kept the networks read before the error");
+    }
+    import_commit(import);
 
-        if (buffer)
+    bool saved = write_credentials_header(import->file, &import->header);
+    close_credentials(import->file);
+    free(import);
+    return saved;
+}
+
+// Function to load the playlist
+bool load_playlist(WiFiPlaylist *playlist)
+{
+    if (!playlist)
+    {
+        FURI_LOG_E(TAG, "Playlist is NULL");
+        return false;
+    }
+    playlist_reset(playlist);
+
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    bool has_json = storage_common_stat(storage, WIFI_SSID_LIST_PATH, NULL) == FSE_OK;
+    uint32_t json_hash = 2166136261u;
+    if (has_json)
+    {
+        has_json = flipper_http_read_file_chunks(WIFI_SSID_LIST_PATH, 0, playlist_json_hash_chunk, &json_hash);
+    }
+
+    // read the SSIDs straight from the store unless wifi_list.txt was edited by hand
+    FlipWiFiCredentialsHeader header;
+    FlipWiFiCredentialsRecord record;
+    File *file = open_credentials(storage, FSAM_READ, &header);
+    if (file && (!has_json || json_hash == header.json_hash))
+    {
+        for (size_t i = 0; i < header.count; i++)
         {
-            // Parse existing SSID length
-            if (file_size >= sizeof(size_t))
+            if (!read_credentials_record(file, &header, i, &record))
             {
-                size_t existing_ssid_length;
-                memcpy(&existing_ssid_length, buffer, sizeof(size_t));
-
-                // Parse existing Password length
-                if (file_size >= sizeof(size_t) + existing_ssid_length + sizeof(size_t))
-                {
-                    size_t existing_password_length;
-                    memcpy(&existing_password_length, buffer + sizeof(size_t) + existing_ssid_length, sizeof(size_t));
-
-                    // Calculate the offset where additional data starts
-                    size_t additional_offset = sizeof(size_t) + existing_ssid_length + sizeof(size_t) + existing_password_length;
-                    if (additional_offset < file_size)
-                    {
-                        additional_data_size = file_size - additional_offset;
-                        additional_data = malloc(additional_data_size);
-                        if (additional_data)
-                        {
-                            memcpy(additional_data, buffer + additional_offset, additional_data_size);
-                        }
-                        else
-                        {
-                            FURI_LOG_E(TAG, "Failed to allocate memory for additional data for app: %s", app_ids[i]);
-                            free(buffer);
-                            furi_record_close(RECORD_STORAGE);
-                            continue;
-                        }
-                    }
-                }
-                else
-                {
-                    FURI_LOG_E(TAG, "Settings file format invalid for app: %s", app_ids[i]);
-                }
+                FURI_LOG_E(TAG, "Failed to read saved network %zu", i);
+                break;
             }
-            else
+            if (!playlist_add(playlist, record.ssid))
             {
-                FURI_LOG_E(TAG, "Settings file too small for app: %s", app_ids[i]);
+                FURI_LOG_E(TAG, "Playlist is full, loaded %zu of %u networks", i, header.count);
+                break;
             }
         }
+        close_credentials(file);
+        furi_record_close(RECORD_STORAGE);
+        return true;
+    }
 
-        // Allocate a new buffer for updated data
-        size_t total_new_size = new_file_size + additional_data_size;
-        uint8_t *new_buffer = malloc(total_new_size);
-        if (!new_buffer)
+    // keep the current selection across the import
+    char active_ssid[MAX_SSID_LENGTH] = {0};
+    if (file)
+    {
+        if (header.active_index < header.count && read_credentials_record(file, &header, header.active_index, &record))
         {
-            FURI_LOG_E(TAG, "Failed to allocate new buffer for app: %s", app_ids[i]);
-            if (buffer)
-                free(buffer);
-            if (additional_data)
-                free(additional_data);
-            furi_record_close(RECORD_STORAGE);
-            continue;
+            snprintf(active_ssid, sizeof(active_ssid), "%s", record.ssid);
         }
+        close_credentials(file);
+    }
 
-        size_t offset = 0;
+    bool loaded = has_json && import_playlist(storage, playlist, active_ssid, json_hash);
+    furi_record_close(RECORD_STORAGE);
+    return loaded;
+}
 
-        // Write new SSID length and SSID
-        memcpy(new_buffer + offset, &new_ssid_length, sizeof(size_t));
-        offset += sizeof(size_t);
-        memcpy(new_buffer + offset, ssid, new_ssid_length);
-        offset += new_ssid_length;
+// Function to load the list of FlipperHTTP app ids that share the WiFi settings
+static size_t load_app_ids(Storage *storage, char app_ids[][MAX_APP_ID_LENGTH], size_t max_apps)
+{
+    size_t count = 0;
+    File *file = storage_file_alloc(storage);
+    if (file && storage_file_open(file, FLIP_WIFI_APPS_PATH, FSAM_READ, FSOM_OPEN_EXISTING))
+    {
+        // one app id per line; anything past the buffer is ignored
+        char buffer[MAX_FLIPPER_HTTP_APPS * MAX_APP_ID_LENGTH];
+        size_t read_count = storage_file_read(file, buffer, sizeof(buffer) - 1);
+        buffer[read_count] = '\0';
+        storage_file_close(file);
 
-        // Write new Password length and Password
-        memcpy(new_buffer + offset, &new_password_length, sizeof(size_t));
-        offset += sizeof(size_t);
-        memcpy(new_buffer + offset, password, new_password_length);
-        offset += new_password_length;
+        char *line = buffer;
+        while (line && *line && count < max_apps)
+        {
+            char *next = strchr(line, '\n');
+            if (next)
+            {
+                *next++ = '\0';
+            }
+            size_t length = strcspn(line, "\r \t");
+            if (length > 0 && length < MAX_APP_ID_LENGTH)
+            {
+                memcpy(app_ids[count], line, length);
+                app_ids[count][length] = '\0';
+                count++;
+            }
+            line = next;
+        }
+    }
+    if (file)
+    {
+        storage_file_free(file);
+    }
 
-        // Append any additional data if present
-        if (additional_data_size > 0 && additional_data)
+    // fall back to the built-in list when apps.txt is missing or empty
+    if (count == 0)
+    {
+        for (size_t i = 0; i < COUNT_OF(default_app_ids) && count < max_apps; i++)
         {
-            memcpy(new_buffer + offset, additional_data, additional_data_size);
-            offset += additional_data_size;
+            snprintf(app_ids[count++], MAX_APP_ID_LENGTH, "%s", default_app_ids[i]);
         }
+    }
+    return count;
+}
 
-        // Free temporary buffers
-        if (buffer)
-            free(buffer);
-        if (additional_data)
-            free(additional_data);
+// Function to make sure the reusable settings buffer can hold at least size bytes
+static bool reserve_settings_buffer(uint8_t **buffer, size_t *capacity, size_t size)
+{
+    if (size <= *capacity)
+    {
+        return true;
+    }
+    uint8_t *grown = realloc(*buffer, size);
+    if (!grown)
+    {
+        return false;
+    }
+    *buffer = grown;
+    *capacity = size;
+    return true;
+}
 
-        // Open the file in write mode with FSOM_CREATE_ALWAYS to overwrite it
-        file = storage_file_alloc(storage);
-        if (!file)
+// Function to get the size of the [len][ssid][len][password] prefix of a settings.bin, or 0 if malformed
+static size_t settings_prefix_size(const uint8_t *buffer, size_t file_size)
+{
+    size_t ssid_length;
+    size_t password_length;
+    if (file_size < sizeof(size_t))
+    {
+        return 0;
+    }
+    memcpy(&ssid_length, buffer, sizeof(size_t));
+    if (ssid_length > file_size - sizeof(size_t) || file_size - sizeof(size_t) - ssid_length < sizeof(size_t))
+    {
+        return 0;
+    }
+    memcpy(&password_length, buffer + sizeof(size_t) + ssid_length, sizeof(size_t));
+    size_t offset = sizeof(size_t) + ssid_length + sizeof(size_t);
+    if (password_length > file_size - offset)
+    {
+        return 0;
+    }
+    return offset + password_length;
+}
+
+void save_settings(const char *ssid, const char *password)
+{
+    char app_ids[MAX_FLIPPER_HTTP_APPS][MAX_APP_ID_LENGTH];
+    char path[128];
+
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    if (!storage)
+    {
+        FURI_LOG_E(TAG, "Failed to open storage record");
+        return;
+    }
+    File *file = storage_file_alloc(storage);
+    if (!file)
+    {
+        FURI_LOG_E(TAG, "Failed to allocate storage file");
+        furi_record_close(RECORD_STORAGE);
+        return;
+    }
+
+    size_t app_count = load_app_ids(storage, app_ids, MAX_FLIPPER_HTTP_APPS);
+
+    // Build the new SSID/password prefix once; every app gets the same bytes
+    size_t ssid_length = strlen(ssid) + 1;         // Including null terminator
+    size_t password_length = strlen(password) + 1; // Including null terminator
+    size_t prefix_size = sizeof(size_t) + ssid_length + sizeof(size_t) + password_length;
+    uint8_t *prefix = malloc(prefix_size);
+    if (!prefix)
+    {
+        FURI_LOG_E(TAG, "Failed to allocate settings prefix");
+        storage_file_free(file);
+        furi_record_close(RECORD_STORAGE);
+        return;
+    }
+    size_t offset = 0;
+    memcpy(prefix + offset, &ssid_length, sizeof(size_t));
+    offset += sizeof(size_t);
+    memcpy(prefix + offset, ssid, ssid_length);
+    offset += ssid_length;
+    memcpy(prefix + offset, &password_length, sizeof(size_t));
+    offset += sizeof(size_t);
+    memcpy(prefix + offset, password, password_length);
+
+    // One buffer reused (and only ever grown) across all of the apps
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+
+    for (size_t i = 0; i < app_count; i++)
+    {
+        // Ensure the directory exists
+        snprintf(path, sizeof(path), STORAGE_EXT_PATH_PREFIX "/apps_data/%s", app_ids[i]);
+        storage_common_mkdir(storage, path);
+        snprintf(path, sizeof(path), STORAGE_EXT_PATH_PREFIX "/apps_data/%s/settings.bin", app_ids[i]);
+
+        if (!storage_file_open(file, path, FSAM_READ_WRITE, FSOM_OPEN_ALWAYS))
         {
-            FURI_LOG_E(TAG, "Failed to allocate storage file for writing: %s", app_ids[i]);
-            free(new_buffer);
-            furi_record_close(RECORD_STORAGE);
+            FURI_LOG_E(TAG, "Failed to open settings file: %s", path);
             continue;
         }
 
-        if (!storage_file_open(file, edited_file_path, FSAM_WRITE, FSOM_CREATE_ALWAYS))
+        size_t file_size = storage_file_size(file);
+        if (!reserve_settings_buffer(&buffer, &capacity, file_size + prefix_size))
         {
-            FURI_LOG_E(TAG, "Failed to open settings file for writing: %s", edited_file_path);
-            storage_file_free(file);
-            free(new_buffer);
-            furi_record_close(RECORD_STORAGE);
+            FURI_LOG_E(TAG, "Failed to allocate buffer for app: %s", app_ids[i]);
+            storage_file_close(file);
+            continue;
+        }
+        if (file_size > 0 && storage_file_read(file, buffer, file_size) != file_size)
+        {
+            FURI_LOG_E(TAG, "Failed to read settings file for app: %s", app_ids[i]);
+            storage_file_close(file);
             continue;
         }
 
-        // Write the updated buffer back to the file
-        if (storage_file_write(file, new_buffer, total_new_size) != total_new_size)
+        // Anything past the existing prefix is app-specific and preserved as-is
+        size_t existing_prefix = settings_prefix_size(buffer, file_size);
+        if (existing_prefix == 0 && file_size > 0)
         {
-            FURI_LOG_E(TAG, "Failed to write updated settings for app: %s", app_ids[i]);
+            FURI_LOG_E(TAG, "Settings file format invalid for app: %s", app_ids[i]);
         }
+        size_t tail_size = file_size - existing_prefix;
 
-        // Clean up
-        free(new_buffer);
+        bool ok = true;
+        if (existing_prefix == prefix_size)
+        {
+            // Same length: skip if identical, otherwise overwrite the prefix in place
+            if (memcmp(buffer, prefix, prefix_size) != 0)
+            {
+                ok = storage_file_seek(file, 0, true) &&
+                     storage_file_write(file, prefix, prefix_size) == prefix_size;
+            }
+        }
+        else
+        {
+            // Length changed: shift the tail behind the new prefix and rewrite the file
+            memmove(buffer + prefix_size, buffer + existing_prefix, tail_size);
+            memcpy(buffer, prefix, prefix_size);
+            size_t total_size = prefix_size + tail_size;
+            ok = storage_file_seek(file, 0, true) &&
+                 storage_file_write(file, buffer, total_size) == total_size &&
+                 storage_file_truncate(file);
+        }
+        if (!ok)
+        {
+            FURI_LOG_E(TAG, "Failed to write updated settings for app: %s", app_ids[i]);
+        }
         storage_file_close(file);
-        storage_file_free(file);
-        furi_record_close(RECORD_STORAGE);
+    }
+
+    // Clean up
+    free(buffer);
+    free(prefix);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+bool settings_compat_enabled(void)
+{
+    char value[4];
+    return load_char(FLIP_WIFI_SETTINGS_COMPAT, value, sizeof(value)) && value[0] == '1';
+}
+
+void settings_compat_set(bool enabled)
+{
+    save_char(FLIP_WIFI_SETTINGS_COMPAT, enabled ? "1" : "0");
+}
+
+static uint32_t credentials_hash_step(uint32_t hash, const char *text)
+{
+    // the terminator is hashed too, so "ab" + "c" differs from "a" + "bc"
+    do
+    {
+        hash ^= (uint8_t)*text;
+        hash *= 16777619u;
+    } while (*text++);
+    return hash;
+}
+
+uint32_t credentials_hash(const char *ssid, const char *password)
+{
+    uint32_t hash = 2166136261u;
+    hash = credentials_hash_step(hash, ssid ? ssid : "");
+    hash = credentials_hash_step(hash, password ? password : "");
+    // turning App Copies on has to fan the network out once more
+    return credentials_hash_step(hash, settings_compat_enabled() ? "1" : "0");
+}
+
+static uint32_t last_good_hash = 0;
+static bool last_good_loaded = false;
+
+bool last_good_matches(uint32_t hash)
+{
+    if (!last_good_loaded)
+    {
+        char value[12];
+        last_good_hash = load_char(FLIP_WIFI_LAST_GOOD, value, sizeof(value)) ? strtoul(value, NULL, 16) : 0;
+        last_good_loaded = true;
+    }
+    return last_good_hash != 0 && last_good_hash == hash;
+}
+
+void last_good_save(uint32_t hash)
+{
+    if (last_good_loaded && last_good_hash == hash)
+    {
+        return;
+    }
+    char value[12];
+    snprintf(value, sizeof(value), "%08lx", (unsigned long)hash);
+    if (save_char(FLIP_WIFI_LAST_GOOD, value))
+    {
+        last_good_hash = hash;
+        last_good_loaded = true;
     }
 }
+
 bool save_char(
     const char *path_name, const char *value)
 {
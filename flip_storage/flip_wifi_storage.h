@@ -5,12 +5,80 @@
 // define the paths for all of the FlipperHTTP apps
 #define WIFI_SSID_LIST_PATH STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data/wifi_list.txt"
 
-// Function to save the playlist
-void save_playlist(WiFiPlaylist *playlist);
+// optional list of app ids (one per line) whose settings.bin receives the selected network
+#define FLIP_WIFI_APPS_PATH STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data/apps.txt"
+#define MAX_FLIPPER_HTTP_APPS 16
+#define MAX_APP_ID_LENGTH 32
 
-// Function to load the playlist
+// shared credentials store: one header followed by fixed-size records, so a FlipperHTTP
+// app can read the active network with a single open, a seek and one read
+#define FLIP_WIFI_CREDENTIALS_PATH STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data/credentials.bin"
+#define FLIP_WIFI_CREDENTIALS_MAGIC 0x52435746 // "FWCR"
+#define FLIP_WIFI_CREDENTIALS_VERSION 1
+#define FLIP_WIFI_CREDENTIALS_NONE 0xFFFF // active_index when no network is selected
+
+// results of the last finished scan, shown right away when the Scan menu is reopened
+#define FLIP_WIFI_SCAN_CACHE_PATH STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data/scan.txt"
+
+typedef struct
+{
+    uint32_t magic;        // FLIP_WIFI_CREDENTIALS_MAGIC
+    uint16_t version;      // FLIP_WIFI_CREDENTIALS_VERSION
+    uint16_t record_size;  // sizeof(FlipWiFiCredentialsRecord); readers must use this to seek
+    uint16_t count;        // number of records following the header
+    uint16_t active_index; // record used by every FlipperHTTP app, or FLIP_WIFI_CREDENTIALS_NONE
+    uint32_t json_hash;    // FNV-1a of wifi_list.txt when last exported/imported
+} FlipWiFiCredentialsHeader;
+
+typedef struct
+{
+    char ssid[MAX_SSID_LENGTH];
+    char password[MAX_SSID_LENGTH];
+} FlipWiFiCredentialsRecord;
+
+// name (for save_char/load_char) of the toggle that also fans out into every app's settings.bin
+#define FLIP_WIFI_SETTINGS_COMPAT "settings-compat"
+
+// name (for save_char/load_char) of the hash of the credentials the board last accepted
+#define FLIP_WIFI_LAST_GOOD "last-good"
+
+// Functions to manage the in-memory SSID index (grows on demand until the heap reserve is hit)
+void playlist_reset(WiFiPlaylist *playlist);
+void playlist_release(WiFiPlaylist *playlist);
+bool playlist_add(WiFiPlaylist *playlist, const char *ssid);
+void playlist_remove(WiFiPlaylist *playlist, size_t index);
+const char *playlist_ssid(const WiFiPlaylist *playlist, size_t index);
+
+// Function to load the SSID index of the playlist, importing wifi_list.txt if it was edited by hand
 bool load_playlist(WiFiPlaylist *playlist);
 
+// Function to read one saved network (SSID and password) from the store
+bool playlist_load_record(size_t index, char *ssid, size_t ssid_size, char *password, size_t password_size);
+
+// Functions to change single records in the store without rewriting the list
+bool playlist_update_record(size_t index, const char *ssid, const char *password);
+bool playlist_append_record(const char *ssid, const char *password);
+bool playlist_delete_record(size_t index);
+bool playlist_set_active(size_t index);
+
+// Function to write wifi_list.txt from the store if it changed this session
+bool export_playlist(void);
+
+// Function to read the active network from the shared credentials store
+bool load_active_credentials(char *ssid, size_t ssid_size, char *password, size_t password_size);
+
+// Function to check/set whether the per-app settings.bin copies are written as well
+bool settings_compat_enabled(void);
+void settings_compat_set(bool enabled);
+
+// Function to hash a network's credentials (FNV-1a over the SSID, the password and the App Copies setting)
+uint32_t credentials_hash(const char *ssid, const char *password);
+
+// Functions to remember the credentials the board last accepted (read from storage once per session)
+bool last_good_matches(uint32_t hash);
+void last_good_save(uint32_t hash);
+
+// Function to write the SSID/password into every FlipperHTTP app's settings.bin
 void save_settings(const char *ssid, const char *password);
 
 bool save_char(
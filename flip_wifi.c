@@ -18,6 +18,13 @@ void flip_wifi_app_free(FlipWiFiApp *app)
     }
 
     flip_wifi_free_all(app);
+    flip_wifi_free_scan(app);
+
+    // refresh the hand-editable wifi_list.txt if the saved networks changed
+    export_playlist();
+
+    // close the uart session
+    flipper_http_session_end();
 
     // free the view dispatcher
     if (app->view_dispatcher)
@@ -26,6 +33,15 @@ void flip_wifi_app_free(FlipWiFiApp *app)
     // close the gui
     furi_record_close(RECORD_GUI);
 
+    // free the arenas
+    json_set_arena_furi(NULL);
+    arena_free(app->json_arena);
+    arena_free(app->arena);
+
+    // free the scan lock (the worker is stopped by now)
+    if (app->scan_mutex)
+        furi_mutex_free(app->scan_mutex);
+
     // free the app
     if (app)
         free(app);
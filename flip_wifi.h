@@ -4,11 +4,21 @@
 #include <flipper_http/flipper_http.h>
 #include <easy_flipper/easy_flipper.h>
 #include <storage/storage.h>
+#include <arena/arena.h>
 
 #define TAG "FlipWiFi"
 #define MAX_SCAN_NETWORKS 100
-#define MAX_SAVED_NETWORKS 25
+#define FLIP_WIFI_PLAYLIST_HEAP_RESERVE (8 * 1024) // saved list stops growing below this much free heap
 #define MAX_SSID_LENGTH 64
+#define MAX_SSID_NAME_LENGTH 33 // 802.11 SSIDs are at most 32 bytes
+#define FLIP_WIFI_ARENA_SIZE (4 * 1024)      // scanned networks
+#define FLIP_WIFI_JSON_ARENA_SIZE (2 * 1024) // JSON tokens of docs parsed on the GUI thread
+#define FLIP_WIFI_PROBE_STACK_SIZE 2048 // startup probe: ping wait and baudrate switch over the session
+#define FLIP_WIFI_SCAN_CACHE_SECONDS 60 // a scan younger than this is shown at once and refreshed in the background
+#if FLIPPER_HTTP_REPLAY
+#define FLIP_WIFI_REPLAY_PATH STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data/replay.txt" // written by Capture, fed back by Replay
+#define FLIP_WIFI_REPLAY_RATE (BAUDRATE / 10) // bytes per second, the UART line rate
+#endif
 
 // Define the submenu items for our FlipWiFi application
 typedef enum
@@ -18,14 +28,30 @@ typedef enum
     FlipWiFiSubmenuIndexWiFiScan,
     FlipWiFiSubmenuIndexWiFiSaved,
     FlipWiFiSubmenuIndexCommands,
+    FlipWiFiSubmenuIndexSettingsCompat,
+    FlipWiFiSubmenuIndexDiagnostics,
+#if FLIPPER_HTTP_REPLAY
+    FlipWiFiSubmenuIndexCapture,
+    FlipWiFiSubmenuIndexReplay,
+#endif
     //
     FlipWiFiSubmenuIndexWiFiSavedAddSSID,
+    FlipWiFiSubmenuIndexWiFiSavedConnectBest,
     //
     FlipWiFiSubmenuIndexFastCommandStart = 50,
     FlipWiFiSubmenuIndexWiFiScanStart = 100,
-    FlipWiFiSubmenuIndexWiFiSavedStart = 200,
+    FlipWiFiSubmenuIndexWiFiSavedStart = 1000, // one item per saved network, up to the store limit
 } FlipWiFiSubmenuIndex;
 
+// Custom events sent to the view dispatcher from the UART worker and the startup probe
+typedef enum
+{
+    FlipWiFiCustomEventScanUpdated, // new scan records arrived
+    FlipWiFiCustomEventScanDone,    // the scan reply finished
+    FlipWiFiCustomEventScanFailed,  // the scan reply timed out or errored
+    FlipWiFiCustomEventProbeDone,   // the startup board probe finished
+} FlipWiFiCustomEvent;
+
 // Define a single view for our FlipWiFi application
 typedef enum
 {
@@ -37,6 +63,7 @@ typedef enum
     FlipWiFiViewSubmenuSaved,    // The submenu for the wifi saved screen
     FlipWiFiViewSubmenuCommands, // The submenu for the fast commands screen
     FlipWiFiViewAbout,           // The about screen
+    FlipWiFiViewDiagnostics,     // The FlipperHTTP counters screen
     FlipWiFiViewTextInputScan,   // The text input screen for the wifi scan screen
     FlipWiFiViewTextInputSaved,  // The text input screen for the wifi saved screen
     //
@@ -48,12 +75,22 @@ typedef enum
     FlipWiFiViewTextInput, // generic text input
 } FlipWiFiView;
 
-// Define the WiFiPlaylist structure
+// Define the WiFiPlaylist structures
+// only the SSIDs are kept in memory; passwords are read from storage when an entry is opened
+typedef struct
+{
+    uint16_t offset; // start of the SSID in the pool
+    uint8_t length;  // SSID length without the terminator
+} WiFiPlaylistEntry;
+
 typedef struct
 {
-    char ssids[MAX_SAVED_NETWORKS][MAX_SSID_LENGTH];
-    char passwords[MAX_SAVED_NETWORKS][MAX_SSID_LENGTH];
-    size_t count;
+    char *pool;                 // NUL-terminated SSIDs packed back to back
+    size_t pool_size;           // bytes of the pool in use
+    size_t pool_capacity;       // bytes allocated for the pool
+    WiFiPlaylistEntry *entries; // one per saved network, in store order
+    size_t count;               // number of saved networks
+    size_t capacity;            // entries allocated
 } WiFiPlaylist;
 
 // Each screen will have its own view
@@ -61,6 +98,7 @@ typedef struct
 {
     ViewDispatcher *view_dispatcher;           // Switches between our views
     Widget *widget_info;                       // The widget for the about screen
+    Widget *widget_diagnostics;                // The widget for the diagnostics screen
     View *view_wifi;                           // generic view for the wifi scan and saved screens
     Submenu *submenu_main;                     // The submenu for the main screen
     Submenu *submenu_wifi;                     // generic submenu for the wifi scan and saved screens
@@ -70,6 +108,10 @@ typedef struct
     char *uart_text_input_buffer;              // Buffer for the text input
     char *uart_text_input_temp_buffer;         // Temporary buffer for the text input
     uint32_t uart_text_input_buffer_size;      // Size of the text input buffer
+    Arena *arena;                              // App-lifetime arena for the scan results
+    Arena *json_arena;                         // JSON tokens; owned by the GUI thread, never reset
+    FuriMutex *scan_mutex;                     // Guards the scan records between the UART worker and the GUI
+    FuriThread *probe_thread;                  // Startup board probe (NULL once joined)
 } FlipWiFiApp;
 
 // Function to free the resources used by FlipWiFiApp
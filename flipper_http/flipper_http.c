@@ -1,8 +1,7 @@
 #include <flipper_http/flipper_http.h>
+#include <stdarg.h>
 FlipperHTTP fhttp;
 char rx_line_buffer[RX_LINE_BUFFER_SIZE];
-uint8_t file_buffer[FILE_BUFFER_SIZE];
-size_t file_buffer_len = 0;
 // Function to append received data to file
 // make sure to initialize the file path before calling this function
 bool flipper_http_append_to_file(
@@ -64,88 +63,1093 @@ bool flipper_http_append_to_file(
     return true;
 }
 
+// Function to read a file in fixed-size blocks
+/**
+ * @brief      Read a file block by block, handing each block to a callback.
+ * @return     true if the whole file was read (or the callback stopped early), false on error.
+ * @param      file_path   The path of the file to read.
+ * @param      chunk_size  The block size in bytes (FILE_READ_CHUNK_SIZE if 0).
+ * @param      callback    Called with each block and its offset; return false to stop.
+ * @param      context     The context passed to the callback.
+ * @note       Memory use is one block however large the file is. Each block is followed by a
+ *             NUL byte (not counted in its length) so text can be appended directly.
+ */
+bool flipper_http_read_file_chunks(const char *file_path, size_t chunk_size, FlipperHTTP_Chunk callback, void *context)
+{
+    if (!file_path || !callback)
+    {
+        FURI_LOG_E(HTTP_TAG, "Invalid arguments provided to flipper_http_read_file_chunks.");
+        return false;
+    }
+    if (chunk_size == 0)
+    {
+        chunk_size = FILE_READ_CHUNK_SIZE;
+    }
+
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    File *file = storage_file_alloc(storage);
+    if (!storage_file_open(file, file_path, FSAM_READ, FSOM_OPEN_EXISTING))
+    {
+        storage_file_free(file);
+        furi_record_close(RECORD_STORAGE);
+        return false; // the file does not exist
+    }
+
+    uint8_t *buffer = (uint8_t *)malloc(chunk_size + 1);
+    if (!buffer)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to allocate buffer");
+        storage_file_close(file);
+        storage_file_free(file);
+        furi_record_close(RECORD_STORAGE);
+        return false;
+    }
+
+    bool success = true;
+    size_t offset = 0;
+    while (true)
+    {
+        size_t read_count = storage_file_read(file, buffer, chunk_size);
+        if (storage_file_get_error(file) != FSE_OK)
+        {
+            FURI_LOG_E(HTTP_TAG, "Error reading from file.");
+            success = false;
+            break;
+        }
+        buffer[read_count] = '\0';
+        if (read_count == 0 || !callback(buffer, read_count, offset, context))
+        {
+            break;
+        }
+        offset += read_count;
+        if (read_count < chunk_size)
+        {
+            break; // end of file
+        }
+    }
+
+    free(buffer);
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return success;
+}
+
+// Function to read part of a file
+/**
+ * @brief      Read up to length bytes of a file starting at offset.
+ * @return     The number of bytes read (0 past the end, or if the file cannot be read).
+ * @param      file_path  The path of the file to read.
+ * @param      offset     The position of the first byte to read.
+ * @param      buffer     The buffer to read into.
+ * @param      length     The size of the buffer.
+ */
+size_t flipper_http_read_file_window(const char *file_path, size_t offset, void *buffer, size_t length)
+{
+    if (!file_path || !buffer)
+    {
+        FURI_LOG_E(HTTP_TAG, "Invalid arguments provided to flipper_http_read_file_window.");
+        return 0;
+    }
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    File *file = storage_file_alloc(storage);
+    size_t read_count = 0;
+    if (storage_file_open(file, file_path, FSAM_READ, FSOM_OPEN_EXISTING))
+    {
+        if (storage_file_seek(file, offset, true))
+        {
+            read_count = storage_file_read(file, buffer, length);
+        }
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return read_count;
+}
+
+// Function to append one block of a file to a string
+static bool flipper_http_load_chunk(const uint8_t *data, size_t length, size_t offset, void *context)
+{
+    UNUSED(length);
+    UNUSED(offset);
+    FuriString *str_result = (FuriString *)context;
+    // flipper_http_read_file_chunks NUL terminates every block, so one append takes it whole
+    furi_string_cat_str(str_result, (const char *)data);
+    return true;
+}
+
 FuriString *flipper_http_load_from_file(char *file_path)
 {
-    // Open the storage record
-    Storage *storage = furi_record_open(RECORD_STORAGE);
-    if (!storage)
+    // Size the string once for the whole file
+    Storage *storage = furi_record_open(RECORD_STORAGE);
+    FileInfo info;
+    bool exists = storage_common_stat(storage, file_path, &info) == FSE_OK;
+    furi_record_close(RECORD_STORAGE);
+    if (!exists)
+    {
+        return NULL; // Return NULL if the file does not exist
+    }
+    if (info.size + FILE_LOAD_HEAP_RESERVE > memmgr_get_free_heap())
+    {
+        FURI_LOG_E(HTTP_TAG, "File too large to load: %lu bytes", (unsigned long)info.size);
+        return NULL;
+    }
+
+    // Allocate a FuriString to hold the file
+    FuriString *str_result = furi_string_alloc();
+    if (!str_result)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to allocate FuriString");
+        return NULL;
+    }
+    furi_string_reserve(str_result, info.size + 1);
+
+    // Append the file block by block
+    if (!flipper_http_read_file_chunks(file_path, FILE_READ_CHUNK_SIZE, flipper_http_load_chunk, str_result))
+    {
+        furi_string_free(str_result);
+        return NULL;
+    }
+    return str_result;
+}
+
+// Function to write to the open response file, timing the card
+static bool flipper_http_storage_write(const void *data, size_t data_size)
+{
+    uint32_t start = furi_get_tick();
+    bool success = storage_file_write(fhttp.file_handle, data, data_size) == data_size;
+    fhttp.stats_request.sd_write_ms += furi_get_tick() - start;
+    return success;
+}
+
+// Function to open the response file once for a whole request
+/**
+ * @brief      Open a file to stream the response of a request into.
+ * @return     true if the file was opened successfully, false otherwise.
+ * @param      file_path       The path of the file to write.
+ * @param      start_new_file  true to truncate the file, false to append to it.
+ * @note       Data written with flipper_http_file_write is buffered until flushed or closed.
+ */
+bool flipper_http_file_open(const char *file_path, bool start_new_file)
+{
+    // Close any file left open by a previous request
+    flipper_http_file_close();
+
+    if (!fhttp.file_write_buffer)
+    {
+        fhttp.file_write_buffer = (uint8_t *)malloc(FILE_WRITE_BUFFER_SIZE);
+        if (!fhttp.file_write_buffer)
+        {
+            FURI_LOG_E(HTTP_TAG, "Failed to allocate file write buffer");
+            return false;
+        }
+    }
+    fhttp.file_write_buffer_len = 0;
+
+    fhttp.file_storage = furi_record_open(RECORD_STORAGE);
+    fhttp.file_handle = storage_file_alloc(fhttp.file_storage);
+    if (!storage_file_open(
+            fhttp.file_handle,
+            file_path,
+            FSAM_WRITE,
+            start_new_file ? FSOM_CREATE_ALWAYS : FSOM_OPEN_APPEND))
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to open file for writing: %s", file_path);
+        storage_file_free(fhttp.file_handle);
+        furi_record_close(RECORD_STORAGE);
+        fhttp.file_handle = NULL;
+        fhttp.file_storage = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Function to write the buffered data to the open response file
+/**
+ * @brief      Write any buffered data to the open response file.
+ * @return     true if the buffer was written successfully, false otherwise.
+ */
+bool flipper_http_file_flush()
+{
+    if (!fhttp.file_handle)
+    {
+        return false;
+    }
+    if (fhttp.file_write_buffer_len == 0)
+    {
+        return true;
+    }
+    bool success = flipper_http_storage_write(fhttp.file_write_buffer, fhttp.file_write_buffer_len);
+    if (!success)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to write buffered data to file");
+    }
+    fhttp.file_write_buffer_len = 0;
+    return success;
+}
+
+// Function to append data to the open response file
+/**
+ * @brief      Append data to the file opened with flipper_http_file_open.
+ * @return     true if the data was buffered or written successfully, false otherwise.
+ * @param      data       The data to append.
+ * @param      data_size  The size of the data.
+ */
+bool flipper_http_file_write(const void *data, size_t data_size)
+{
+    if (!fhttp.file_handle)
+    {
+        FURI_LOG_E(HTTP_TAG, "No file open to write to");
+        return false;
+    }
+
+    // Top up the buffer and write it once it is full, so the card only sees whole blocks
+    const uint8_t *bytes = (const uint8_t *)data;
+    if (fhttp.file_write_buffer_len > 0 || data_size < FILE_WRITE_BUFFER_SIZE)
+    {
+        size_t copy_len = MIN(data_size, (size_t)(FILE_WRITE_BUFFER_SIZE - fhttp.file_write_buffer_len));
+        memcpy(&fhttp.file_write_buffer[fhttp.file_write_buffer_len], bytes, copy_len);
+        fhttp.file_write_buffer_len += copy_len;
+        bytes += copy_len;
+        data_size -= copy_len;
+        if (fhttp.file_write_buffer_len < FILE_WRITE_BUFFER_SIZE)
+        {
+            return true;
+        }
+        if (!flipper_http_file_flush())
+        {
+            return false;
+        }
+    }
+
+    // Whole blocks bypass the buffer
+    size_t direct_len = data_size - data_size % FILE_WRITE_BUFFER_SIZE;
+    if (direct_len > 0 && !flipper_http_storage_write(bytes, direct_len))
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to append data to file");
+        return false;
+    }
+
+    // Keep the tail for the next block
+    memcpy(fhttp.file_write_buffer, bytes + direct_len, data_size - direct_len);
+    fhttp.file_write_buffer_len = data_size - direct_len;
+    return true;
+}
+
+// Function to flush and close the open response file on the calling thread
+static void flipper_http_file_close_now()
+{
+    if (fhttp.file_handle)
+    {
+        flipper_http_file_flush();
+        storage_file_close(fhttp.file_handle);
+        storage_file_free(fhttp.file_handle);
+        furi_record_close(RECORD_STORAGE);
+        fhttp.file_handle = NULL;
+        fhttp.file_storage = NULL;
+    }
+    if (fhttp.file_write_buffer)
+    {
+        free(fhttp.file_write_buffer);
+        fhttp.file_write_buffer = NULL;
+    }
+    fhttp.file_write_buffer_len = 0;
+}
+
+// Function to flush and close the open response file
+/**
+ * @brief      Flush and close the file opened with flipper_http_file_open.
+ * @return     void
+ * @note       Safe to call when no file is open. Called from another thread while the worker runs,
+ *             the worker closes the file and this waits until it is done.
+ */
+void flipper_http_file_close()
+{
+    // the worker writes the file; any other thread has it closed there instead of racing it
+    if (fhttp.rx_thread && fhttp.file_closed && furi_thread_get_current_id() != fhttp.rx_thread_id)
+    {
+        furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtFileCloseSync);
+        furi_semaphore_acquire(fhttp.file_closed, FuriWaitForever);
+        return;
+    }
+    flipper_http_file_close_now();
+}
+
+// Function to append to the response file, opening it on the first write of a request
+static bool flipper_http_save_to_file(const void *data, size_t data_size, bool start_new_file)
+{
+    if (!fhttp.file_handle && !flipper_http_file_open(fhttp.file_path, start_new_file))
+    {
+        return false;
+    }
+    return flipper_http_file_write(data, data_size);
+}
+
+// Function to receive payload lines as they arrive
+/**
+ * @brief      Set a hook that is handed every payload line (not framing, status or error lines).
+ * @return     void
+ * @param      callback  The hook (NULL to detach); runs on the UART worker thread.
+ * @param      context   The context passed to the hook.
+ * @note       Lets a reply be parsed while it arrives instead of from a saved file. While a hook is set,
+ *             a command whose reply is plain payload completes when the hook returns true.
+ */
+void flipper_http_set_line_callback(FlipperHTTP_Line callback, void *context)
+{
+    fhttp.line_callback = callback;
+    fhttp.line_context = context;
+}
+
+// Kinds of line the board sends
+typedef enum
+{
+    FlipperHTTPLinePayload, // response data (anything that is not a marker below)
+    FlipperHTTPLineGetSuccess,
+    FlipperHTTPLinePostSuccess,
+    FlipperHTTPLinePutSuccess,
+    FlipperHTTPLineDeleteSuccess,
+    FlipperHTTPLineGetEnd,
+    FlipperHTTPLinePostEnd,
+    FlipperHTTPLinePutEnd,
+    FlipperHTTPLineDeleteEnd,
+    FlipperHTTPLineSuccess,
+    FlipperHTTPLineConnected,
+    FlipperHTTPLineInfo,
+    FlipperHTTPLineDisconnected,
+    FlipperHTTPLineError,
+    FlipperHTTPLinePong,
+    FlipperHTTPLineCount,
+} FlipperHTTPLine;
+
+// Markers of each kind of line, indexed by FlipperHTTPLine
+#define LINE_MARKER(text) {text, sizeof(text) - 1}
+static const struct
+{
+    const char *marker;
+    size_t length;
+} flipper_http_line_markers[FlipperHTTPLineCount] = {
+    [FlipperHTTPLinePayload] = {NULL, 0},
+    [FlipperHTTPLineGetSuccess] = LINE_MARKER("[GET/SUCCESS]"),
+    [FlipperHTTPLinePostSuccess] = LINE_MARKER("[POST/SUCCESS]"),
+    [FlipperHTTPLinePutSuccess] = LINE_MARKER("[PUT/SUCCESS]"),
+    [FlipperHTTPLineDeleteSuccess] = LINE_MARKER("[DELETE/SUCCESS]"),
+    [FlipperHTTPLineGetEnd] = LINE_MARKER("[GET/END]"),
+    [FlipperHTTPLinePostEnd] = LINE_MARKER("[POST/END]"),
+    [FlipperHTTPLinePutEnd] = LINE_MARKER("[PUT/END]"),
+    [FlipperHTTPLineDeleteEnd] = LINE_MARKER("[DELETE/END]"),
+    [FlipperHTTPLineSuccess] = LINE_MARKER("[SUCCESS]"),
+    [FlipperHTTPLineConnected] = LINE_MARKER("[CONNECTED]"),
+    [FlipperHTTPLineInfo] = LINE_MARKER("[INFO]"),
+    [FlipperHTTPLineDisconnected] = LINE_MARKER("[DISCONNECTED]"),
+    [FlipperHTTPLineError] = LINE_MARKER("[ERROR]"),
+    [FlipperHTTPLinePong] = LINE_MARKER("[PONG]"),
+};
+
+static const char *const flipper_http_verb_names[] = {"", "GET", "POST", "PUT", "DELETE"};
+
+// Function to get the END line that completes a request of the given verb
+static FlipperHTTPLine flipper_http_end_line(FlipperHTTPVerb verb)
+{
+    return (FlipperHTTPLine)(FlipperHTTPLineGetEnd + (verb - FlipperHTTPVerbGet));
+}
+
+// How the reply to a command arrives
+typedef enum
+{
+    FlipperHTTPReplyText,  // status or text lines
+    FlipperHTTPReplyJson,  // a JSON body between the SUCCESS and END markers
+    FlipperHTTPReplyBytes, // raw bytes up to the END marker (received with is_bytes_request)
+} FlipperHTTPReplyKind;
+
+// Commands sent to the board, indexing flipper_http_commands
+typedef enum
+{
+    FlipperHTTPCommandPing,
+    FlipperHTTPCommandList,
+    FlipperHTTPCommandLedOn,
+    FlipperHTTPCommandLedOff,
+    FlipperHTTPCommandParse,
+    FlipperHTTPCommandParseArray,
+    FlipperHTTPCommandBaudrate,
+    FlipperHTTPCommandWifiScan,
+    FlipperHTTPCommandWifiSave,
+    FlipperHTTPCommandWifiIp,
+    FlipperHTTPCommandWifiConnect,
+    FlipperHTTPCommandWifiDisconnect,
+    FlipperHTTPCommandIpAddress,
+    FlipperHTTPCommandGet,
+    FlipperHTTPCommandGetHttp,
+    FlipperHTTPCommandGetBytes,
+    FlipperHTTPCommandPostHttp,
+    FlipperHTTPCommandPostBytes,
+    FlipperHTTPCommandPutHttp,
+    FlipperHTTPCommandDeleteHttp,
+    FlipperHTTPCommandCustom, // raw text from flipper_http_send_data that matches no tag
+} FlipperHTTPCommand;
+
+// Every command: its tag, the marker its reply starts with (Payload if the reply has none),
+// its timeout budgets, how the reply arrives and whether it may be sent before the board
+// answered a PING
+#define COMMAND(tag, reply, timeout, kind, inactive) {tag, sizeof(tag) - 1, reply, timeout, kind, inactive}
+static const struct
+{
+    const char *tag;
+    uint8_t length;
+    FlipperHTTPLine reply;
+    FlipperHTTPTimeoutClass timeout;
+    FlipperHTTPReplyKind kind;
+    bool when_inactive;
+} flipper_http_commands[FlipperHTTPCommandCustom] = {
+    [FlipperHTTPCommandPing] = COMMAND("[PING]", FlipperHTTPLinePong, FlipperHTTPTimeoutPing, FlipperHTTPReplyText, true),
+    [FlipperHTTPCommandList] = COMMAND("[LIST]", FlipperHTTPLinePayload, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandLedOn] = COMMAND("[LED/ON]", FlipperHTTPLineSuccess, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandLedOff] = COMMAND("[LED/OFF]", FlipperHTTPLineSuccess, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandParse] = COMMAND("[PARSE]", FlipperHTTPLinePayload, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandParseArray] = COMMAND("[PARSE/ARRAY]", FlipperHTTPLinePayload, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandBaudrate] = COMMAND("[UART/BAUDRATE]", FlipperHTTPLineSuccess, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandWifiScan] = COMMAND("[WIFI/SCAN]", FlipperHTTPLinePayload, FlipperHTTPTimeoutScan, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandWifiSave] = COMMAND("[WIFI/SAVE]", FlipperHTTPLineSuccess, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandWifiIp] = COMMAND("[WIFI/IP]", FlipperHTTPLinePayload, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandWifiConnect] = COMMAND("[WIFI/CONNECT]", FlipperHTTPLineSuccess, FlipperHTTPTimeoutConnect, FlipperHTTPReplyText, true),
+    [FlipperHTTPCommandWifiDisconnect] = COMMAND("[WIFI/DISCONNECT]", FlipperHTTPLineDisconnected, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandIpAddress] = COMMAND("[IP/ADDRESS]", FlipperHTTPLinePayload, FlipperHTTPTimeoutDefault, FlipperHTTPReplyText, false),
+    [FlipperHTTPCommandGet] = COMMAND("[GET]", FlipperHTTPLineGetSuccess, FlipperHTTPTimeoutHttp, FlipperHTTPReplyJson, false),
+    [FlipperHTTPCommandGetHttp] = COMMAND("[GET/HTTP]", FlipperHTTPLineGetSuccess, FlipperHTTPTimeoutHttp, FlipperHTTPReplyJson, false),
+    [FlipperHTTPCommandGetBytes] = COMMAND("[GET/BYTES]", FlipperHTTPLineGetSuccess, FlipperHTTPTimeoutHttp, FlipperHTTPReplyBytes, false),
+    [FlipperHTTPCommandPostHttp] = COMMAND("[POST/HTTP]", FlipperHTTPLinePostSuccess, FlipperHTTPTimeoutHttp, FlipperHTTPReplyJson, false),
+    [FlipperHTTPCommandPostBytes] = COMMAND("[POST/BYTES]", FlipperHTTPLinePostSuccess, FlipperHTTPTimeoutHttp, FlipperHTTPReplyBytes, false),
+    [FlipperHTTPCommandPutHttp] = COMMAND("[PUT/HTTP]", FlipperHTTPLinePutSuccess, FlipperHTTPTimeoutHttp, FlipperHTTPReplyJson, false),
+    [FlipperHTTPCommandDeleteHttp] = COMMAND("[DELETE/HTTP]", FlipperHTTPLineDeleteSuccess, FlipperHTTPTimeoutHttp, FlipperHTTPReplyJson, false),
+};
+_Static_assert(FlipperHTTPCommandCustom + 1 == FLIPPER_HTTP_COMMAND_COUNT, "FLIPPER_HTTP_COMMAND_COUNT is out of date");
+
+// Commands grouped by the letter after '[', so a raw line is only compared with the tags it can match
+static const struct
+{
+    uint8_t count;
+    uint8_t commands[6];
+} flipper_http_commands_by_letter['Z' - 'A' + 1] = {
+    ['D' - 'A'] = {1, {FlipperHTTPCommandDeleteHttp}},
+    ['G' - 'A'] = {3, {FlipperHTTPCommandGet, FlipperHTTPCommandGetHttp, FlipperHTTPCommandGetBytes}},
+    ['I' - 'A'] = {1, {FlipperHTTPCommandIpAddress}},
+    ['L' - 'A'] = {3, {FlipperHTTPCommandList, FlipperHTTPCommandLedOn, FlipperHTTPCommandLedOff}},
+    ['P' - 'A'] = {6, {FlipperHTTPCommandPing, FlipperHTTPCommandParse, FlipperHTTPCommandParseArray, FlipperHTTPCommandPostHttp, FlipperHTTPCommandPostBytes, FlipperHTTPCommandPutHttp}},
+    ['U' - 'A'] = {1, {FlipperHTTPCommandBaudrate}},
+    ['W' - 'A'] = {5, {FlipperHTTPCommandWifiScan, FlipperHTTPCommandWifiSave, FlipperHTTPCommandWifiIp, FlipperHTTPCommandWifiConnect, FlipperHTTPCommandWifiDisconnect}},
+};
+
+// Function to find the table entry of a raw command line
+static FlipperHTTPCommand flipper_http_find_command(const char *line)
+{
+    if (line[0] != '[' || line[1] < 'A' || line[1] > 'Z')
+    {
+        return FlipperHTTPCommandCustom;
+    }
+    // every tag ends with ']', so no tag is a prefix of another and the first match is the one
+    const uint8_t *commands = flipper_http_commands_by_letter[line[1] - 'A'].commands;
+    for (size_t i = 0; i < flipper_http_commands_by_letter[line[1] - 'A'].count; i++)
+    {
+        if (strncmp(line, flipper_http_commands[commands[i]].tag, flipper_http_commands[commands[i]].length) == 0)
+        {
+            return (FlipperHTTPCommand)commands[i];
+        }
+    }
+    return FlipperHTTPCommandCustom;
+}
+
+// Budgets of each kind of command; the connect budget is the ceiling of the adapted one
+static const FlipperHTTPTimeout flipper_http_timeout_budgets[FlipperHTTPTimeoutClassCount] = {
+    [FlipperHTTPTimeoutDefault] = {TIMEOUT_DURATION_TICKS, TIMEOUT_DURATION_TICKS, 2 * TIMEOUT_DURATION_TICKS},
+    [FlipperHTTPTimeoutPing] = {2 * 1000, 1000, 3 * 1000},
+    [FlipperHTTPTimeoutScan] = {10 * 1000, 3 * 1000, 15 * 1000},
+    [FlipperHTTPTimeoutConnect] = {15 * 1000, 5 * 1000, 20 * 1000},
+    // a download is only limited by its idle gap, however long the body is
+    [FlipperHTTPTimeoutHttp] = {10 * 1000, TIMEOUT_DURATION_TICKS, 0},
+};
+
+// Function to fold a sample into a running average (weight 1/4, the first sample seeds it)
+static uint32_t flipper_http_average(uint32_t average, uint32_t sample)
+{
+    return average == 0 ? sample : average - average / 4 + sample / 4;
+}
+
+// Function to adapt a budget to the observed time, within its ceiling
+static uint32_t flipper_http_adapt_budget(uint32_t observed_ms, uint32_t ceiling_ms)
+{
+    if (observed_ms == 0)
+    {
+        return ceiling_ms; // nothing observed yet
+    }
+    return MIN(MAX(3 * observed_ms + TIMEOUT_MARGIN_MS, (uint32_t)TIMEOUT_MIN_MS), ceiling_ms);
+}
+
+// Function to pick the timeout budgets for a command about to be sent; only the wait for the
+// first byte adapts (to that command's own history), how long the reply runs depends on its size
+static void flipper_http_plan_timeout(FlipperHTTPCommand command)
+{
+    FlipperHTTPTimeoutClass kind = command < FlipperHTTPCommandCustom ? flipper_http_commands[command].timeout : FlipperHTTPTimeoutDefault;
+    const FlipperHTTPTimeout *ceiling = &flipper_http_timeout_budgets[kind];
+    fhttp.command = command;
+    fhttp.timeout.connect_ms = flipper_http_adapt_budget(fhttp.observed_first_byte_ms[command], ceiling->connect_ms);
+    fhttp.timeout.idle_ms = ceiling->idle_ms;
+    fhttp.timeout.total_ms = ceiling->total_ms;
+    fhttp.last_activity_tick = 0;
+}
+
+// Function to have the watchdog check the request in flight
+static void flipper_http_arm_timeout()
+{
+    fhttp.timeout_expired = false;
+    fhttp.timeout_armed = true;
+    if (!furi_timer_is_running(fhttp.get_timeout_timer))
+    {
+        furi_timer_start(fhttp.get_timeout_timer, furi_ms_to_ticks(TIMEOUT_TICK_MS));
+    }
+}
+
+// Function to stop the watchdog once nothing is in flight
+static void flipper_http_disarm_timeout()
+{
+    fhttp.timeout_armed = false;
+    if (fhttp.get_timeout_timer)
+    {
+        furi_timer_stop(fhttp.get_timeout_timer);
+    }
+}
+
+// Function to start counting for a request that was just sent
+static void flipper_http_start_stats()
+{
+    memset(&fhttp.stats_request, 0, sizeof(fhttp.stats_request));
+    fhttp.request_start_tick = furi_get_tick();
+    fhttp.first_byte_seen = false;
+    fhttp.rx_dropped_at_start = fhttp.rx_dropped;
+}
+
+// Function to count bytes taken from the stream buffer
+static void flipper_http_count_bytes(size_t received, size_t waiting)
+{
+    if (!fhttp.first_byte_seen && fhttp.request_start_tick != 0)
+    {
+        fhttp.stats_request.first_byte_ms = furi_get_tick() - fhttp.request_start_tick;
+        fhttp.first_byte_seen = true;
+    }
+    fhttp.stats_request.bytes_received += received;
+    fhttp.last_activity_tick = furi_get_tick(); // read by the watchdog, no timer call per line
+    if (waiting > fhttp.stats_request.stream_high_water)
+    {
+        fhttp.stats_request.stream_high_water = waiting;
+    }
+}
+
+// Function to close the counters of the request in flight (request_mutex held)
+static void flipper_http_record_stats(bool success)
+{
+    FlipperHTTPStats *request = &fhttp.stats_request;
+    if (fhttp.request_start_tick != 0)
+    {
+        request->transfer_ms = furi_get_tick() - fhttp.request_start_tick;
+        // successful responses teach the connect budget of their command
+        if (success && fhttp.first_byte_seen)
+        {
+            fhttp.observed_first_byte_ms[fhttp.command] = flipper_http_average(fhttp.observed_first_byte_ms[fhttp.command], request->first_byte_ms);
+        }
+    }
+    request->requests = 1;
+    request->dropped_bytes = fhttp.rx_dropped - fhttp.rx_dropped_at_start;
+    fhttp.stats_last = *request;
+
+    FlipperHTTPStats *total = &fhttp.stats_total;
+    total->requests++;
+    total->timeouts += request->timeouts;
+    total->first_byte_ms += request->first_byte_ms;
+    total->transfer_ms += request->transfer_ms;
+    total->bytes_received += request->bytes_received;
+    total->lines_received += request->lines_received;
+    total->dropped_bytes += request->dropped_bytes;
+    total->sd_write_ms += request->sd_write_ms;
+    total->stream_high_water = MAX(total->stream_high_water, request->stream_high_water);
+
+    memset(request, 0, sizeof(*request));
+    fhttp.request_start_tick = 0;
+    fhttp.rx_dropped_at_start = fhttp.rx_dropped;
+}
+
+// Function to read the request counters
+/**
+ * @brief      Copy the counters of the last completed request and the session totals.
+ * @return     void
+ * @param      last   Set to the counters of the last completed request (may be NULL).
+ * @param      total  Set to the counters added up over the session (may be NULL).
+ * @note       Times are in milliseconds; the totals add them up, divide by requests for averages.
+ */
+void flipper_http_get_stats(FlipperHTTPStats *last, FlipperHTTPStats *total)
+{
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+    }
+    if (last)
+    {
+        *last = fhttp.stats_last;
+    }
+    if (total)
+    {
+        *total = fhttp.stats_total;
+    }
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_release(fhttp.request_mutex);
+    }
+}
+
+// Function to clear the request counters
+/**
+ * @brief      Reset the counters of the last request and the session totals.
+ * @return     void
+ */
+void flipper_http_reset_stats()
+{
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+    }
+    memset(&fhttp.stats_last, 0, sizeof(fhttp.stats_last));
+    memset(&fhttp.stats_total, 0, sizeof(fhttp.stats_total));
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_release(fhttp.request_mutex);
+    }
+}
+
+// Function to complete the request in flight
+/**
+ * @brief      Finish the request in flight: report it, wake the waiter and move the queue on.
+ * @return     void
+ * @param      success  false if the request failed or timed out.
+ */
+static void flipper_http_complete_request(bool success)
+{
+    // The response is over, its timeout no longer applies
+    flipper_http_disarm_timeout();
+
+    FlipperHTTPRequest done = {0};
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+        done = fhttp.request;
+        memset(&fhttp.request, 0, sizeof(fhttp.request));
+        fhttp.timeout_expired = false; // a timeout still pending is for this request
+        flipper_http_record_stats(success);
+        furi_mutex_release(fhttp.request_mutex);
+    }
+
+    if (done.on_complete)
+    {
+        done.on_complete(done.id, success, fhttp.last_response, done.on_complete_context);
+    }
+
+    // Wake whoever waits on the response
+    if (fhttp.response_done)
+    {
+        furi_semaphore_release(fhttp.response_done);
+    }
+
+    // Let the worker send the next queued command
+    if (fhttp.rx_thread)
+    {
+        furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtQueueNext);
+    }
+}
+
+static bool flipper_http_send_line(const char *data, bool queued);
+
+// Function to send the next queued command if nothing is in flight
+static void flipper_http_send_next()
+{
+    furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+    bool busy = fhttp.request.id != 0 || fhttp.request.receiving != FlipperHTTPVerbNone;
+    furi_mutex_release(fhttp.request_mutex);
+    if (busy)
+    {
+        return;
+    }
+
+    FlipperHTTPQueuedCommand next;
+    if (furi_message_queue_get(fhttp.request_queue, &next, 0) != FuriStatusOk)
+    {
+        return;
+    }
+
+    furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+    fhttp.request.id = next.id;
+    fhttp.request.on_complete = next.on_complete;
+    fhttp.request.on_complete_context = next.on_complete_context;
+    furi_mutex_release(fhttp.request_mutex);
+
+    if (!flipper_http_send_line(next.command, true))
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to send queued command %lu.", next.id);
+        flipper_http_complete_request(false);
+        return;
+    }
+}
+
+// Function to queue a command behind the request in flight
+/**
+ * @brief      Queue a command to send as soon as the request in flight completes.
+ * @return     The request id passed to on_complete, or 0 if the command could not be queued.
+ * @param      command              The command to send (ex. "[WIFI/CONNECT]").
+ * @param      on_complete          Called with the result when the response completes (may be NULL).
+ * @param      on_complete_context  The context to pass to on_complete.
+ * @note       Lets callers chain commands (ex. PING, WIFI/CONNECT, IP/WIFI) without blocking between them.
+ *             on_complete runs on the worker thread, so it must not block.
+ */
+uint32_t flipper_http_enqueue(const char *command, FlipperHTTP_Complete on_complete, void *on_complete_context)
+{
+    if (!command || !fhttp.request_queue)
     {
-        FURI_LOG_E(HTTP_TAG, "Failed to open storage record");
-        return NULL;
+        FURI_LOG_E(HTTP_TAG, "Invalid arguments or FlipperHTTP is not initialized.");
+        return 0;
     }
 
-    // Allocate a file handle
-    File *file = storage_file_alloc(storage);
-    if (!file)
+    FlipperHTTPQueuedCommand queued;
+    if (strlen(command) >= sizeof(queued.command))
     {
-        FURI_LOG_E(HTTP_TAG, "Failed to allocate storage file");
-        furi_record_close(RECORD_STORAGE);
-        return NULL;
+        FURI_LOG_E(HTTP_TAG, "Command too long to queue.");
+        return 0;
     }
+    if (fhttp.next_request_id == 0)
+    {
+        fhttp.next_request_id = 1; // 0 marks a direct send
+    }
+    queued.id = fhttp.next_request_id++;
+    snprintf(queued.command, sizeof(queued.command), "%s", command);
+    queued.on_complete = on_complete;
+    queued.on_complete_context = on_complete_context;
 
-    // Open the file for reading
-    if (!storage_file_open(file, file_path, FSAM_READ, FSOM_OPEN_EXISTING))
+    if (furi_message_queue_put(fhttp.request_queue, &queued, 0) != FuriStatusOk)
     {
-        storage_file_free(file);
-        furi_record_close(RECORD_STORAGE);
-        return NULL; // Return false if the file does not exist
+        FURI_LOG_E(HTTP_TAG, "Request queue is full.");
+        return 0;
     }
+    furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtQueueNext);
+    return queued.id;
+}
 
-    // Allocate a FuriString to hold the received data
-    FuriString *str_result = furi_string_alloc();
-    if (!str_result)
+// Function to check whether a line starts with the marker of a kind of line
+static bool flipper_http_line_is(const char *line, size_t len, FlipperHTTPLine kind)
+{
+    return len >= flipper_http_line_markers[kind].length &&
+           memcmp(line, flipper_http_line_markers[kind].marker, flipper_http_line_markers[kind].length) == 0;
+}
+
+// Function to classify a received line and trim it in place
+/**
+ * @brief      Classify a received line by its marker, in a single pass and without copying.
+ * @return     The kind of line.
+ * @param      line      The received line.
+ * @param      text      Set to the start of the line without leading whitespace.
+ * @param      text_len  Set to the length of the line without surrounding whitespace.
+ * @note       The marker the command in flight expects is tried before the others.
+ *             END markers are also matched at the end of the line, where bytes responses put them.
+ */
+static FlipperHTTPLine flipper_http_classify_line(const char *line, const char **text, size_t *text_len)
+{
+    size_t len = strlen(line);
+    while (len > 0 && isspace((unsigned char)*line))
     {
-        FURI_LOG_E(HTTP_TAG, "Failed to allocate FuriString");
-        storage_file_close(file);
-        storage_file_free(file);
-        furi_record_close(RECORD_STORAGE);
-        return NULL;
+        line++;
+        len--;
+    }
+    while (len > 0 && isspace((unsigned char)line[len - 1]))
+    {
+        len--;
+    }
+    *text = line;
+    *text_len = len;
+
+    if (len > 0 && line[0] == '[')
+    {
+        FlipperHTTPLine expected = (FlipperHTTPLine)fhttp.expected_line;
+        if (expected != FlipperHTTPLinePayload && flipper_http_line_is(line, len, expected))
+        {
+            return expected;
+        }
+        for (size_t i = FlipperHTTPLinePayload + 1; i < FlipperHTTPLineCount; i++)
+        {
+            if (flipper_http_line_is(line, len, (FlipperHTTPLine)i))
+            {
+                return (FlipperHTTPLine)i;
+            }
+        }
+    }
+    if (len > 0 && line[len - 1] == ']')
+    {
+        for (size_t i = FlipperHTTPLineGetEnd; i <= FlipperHTTPLineDeleteEnd; i++)
+        {
+            size_t marker_len = flipper_http_line_markers[i].length;
+            if (len >= marker_len &&
+                memcmp(line + len - marker_len, flipper_http_line_markers[i].marker, marker_len) == 0)
+            {
+                return (FlipperHTTPLine)i;
+            }
+        }
     }
+    return FlipperHTTPLinePayload;
+}
 
-    // Reset the FuriString to ensure it's empty before reading
-    furi_string_reset(str_result);
+// Function to finish a GET/POST/PUT/DELETE response once its END marker arrives
+static void flipper_http_finish_response(FlipperHTTPVerb verb)
+{
+    FURI_LOG_I(HTTP_TAG, "%s request completed.", flipper_http_verb_names[verb]);
+    // Stop the watchdog since we've completed the request
+    flipper_http_disarm_timeout();
+    fhttp.request.receiving = FlipperHTTPVerbNone;
+    fhttp.state = IDLE;
+    fhttp.save_bytes = false;
+    fhttp.save_received_data = false;
+    fhttp.bytes_match = 0;
+
+    // The response is complete, close the file
+    flipper_http_file_close();
+
+    fhttp.is_bytes_request = false;
+    flipper_http_complete_request(true);
+}
 
-    // Define a buffer to hold the read data
-    uint8_t *buffer = (uint8_t *)malloc(MAX_FILE_SHOW);
-    if (!buffer)
+// Function to write part of a bytes response to the file
+static void flipper_http_write_bytes(const void *data, size_t data_len)
+{
+    if (data_len == 0)
     {
-        FURI_LOG_E(HTTP_TAG, "Failed to allocate buffer");
-        furi_string_free(str_result);
-        storage_file_close(file);
-        storage_file_free(file);
-        furi_record_close(RECORD_STORAGE);
-        return NULL;
+        return;
     }
+    if (!flipper_http_save_to_file(data, data_len, fhttp.just_started_bytes))
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to append data to file");
+    }
+    fhttp.just_started_bytes = false;
+}
 
-    // Read data into the buffer
-    size_t read_count = storage_file_read(file, buffer, MAX_FILE_SHOW);
-    if (storage_file_get_error(file) != FSE_OK)
+// Function to take a block of a bytes response
+/**
+ * @brief      Write a block of a bytes response straight to the file, watching for the END marker.
+ * @return     The number of bytes consumed (less than data_len if the END marker ends the response).
+ * @param      data      The received bytes.
+ * @param      data_len  The number of received bytes.
+ * @note       Bytes matching the start of the marker are held back until they either complete it
+ *             (the response ends and the marker is dropped) or stop matching (they were data).
+ *             A match may span blocks. END markers only contain '[' as their first byte, so a
+ *             failed match can always restart at the current byte.
+ */
+static size_t flipper_http_receive_bytes(const uint8_t *data, size_t data_len)
+{
+    FlipperHTTPVerb verb = fhttp.request.receiving;
+    const char *marker = flipper_http_line_markers[flipper_http_end_line(verb)].marker;
+    const size_t marker_len = flipper_http_line_markers[flipper_http_end_line(verb)].length;
+
+    size_t span_start = 0; // first byte of the block not written yet
+    for (size_t i = 0; i < data_len; i++)
     {
-        FURI_LOG_E(HTTP_TAG, "Error reading from file.");
-        furi_string_free(str_result);
-        storage_file_close(file);
-        storage_file_free(file);
+        if (data[i] != (uint8_t)marker[fhttp.bytes_match] && fhttp.bytes_match > 0)
+        {
+            // the held bytes were data: the ones from earlier blocks are a marker prefix,
+            // the ones from this block stay in the span
+            size_t held_here = i - span_start;
+            flipper_http_write_bytes(marker, fhttp.bytes_match - held_here);
+            fhttp.bytes_match = 0;
+        }
+        if (data[i] == (uint8_t)marker[fhttp.bytes_match])
+        {
+            if (fhttp.bytes_match == 0)
+            {
+                // a marker may start here: write what came before it
+                flipper_http_write_bytes(data + span_start, i - span_start);
+                span_start = i;
+            }
+            if (++fhttp.bytes_match == marker_len)
+            {
+                flipper_http_finish_response(verb);
+                return i + 1;
+            }
+        }
+    }
+
+    // a partial match at the end of the block is held back for the next one
+    if (fhttp.bytes_match == 0)
+    {
+        flipper_http_write_bytes(data + span_start, data_len - span_start);
+    }
+    return data_len;
+}
+
+// Function to hand the assembled line to the callback and reset the line buffer
+static void flipper_http_emit_line(size_t *rx_line_pos)
+{
+    rx_line_buffer[*rx_line_pos] = '\0'; // Null-terminate the line
+    fhttp.stats_request.lines_received++;
+
+    // Invoke the callback with the complete line
+    fhttp.handle_rx_line_cb(rx_line_buffer, fhttp.callback_context);
+
+    // Reset the line buffer position
+    *rx_line_pos = 0;
+}
+
+#if FLIPPER_HTTP_REPLAY
+// Function to copy received bytes to the capture file
+static void flipper_http_capture_bytes(const void *data, size_t data_len)
+{
+    furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+    if (fhttp.capture_file && storage_file_write(fhttp.capture_file, data, data_len) != data_len)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to write the capture file");
+    }
+    furi_mutex_release(fhttp.request_mutex);
+}
+
+// Function to capture the received UART bytes to a file
+/**
+ * @brief      Copy every byte the worker receives to a file, for replaying later.
+ * @return     true if the capture file was opened (or the capture stopped), false otherwise.
+ * @param      file_path  The file to write (NULL to stop capturing).
+ */
+bool flipper_http_capture(const char *file_path)
+{
+    if (!fhttp.request_mutex)
+    {
+        FURI_LOG_E(HTTP_TAG, "FlipperHTTP is not initialized.");
+        return false;
+    }
+    furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+    if (fhttp.capture_file)
+    {
+        storage_file_close(fhttp.capture_file);
+        storage_file_free(fhttp.capture_file);
         furi_record_close(RECORD_STORAGE);
-        return NULL;
+        fhttp.capture_file = NULL;
+    }
+    bool success = true;
+    if (file_path)
+    {
+        fhttp.capture_file = storage_file_alloc(furi_record_open(RECORD_STORAGE));
+        if (!storage_file_open(fhttp.capture_file, file_path, FSAM_WRITE, FSOM_CREATE_ALWAYS))
+        {
+            FURI_LOG_E(HTTP_TAG, "Failed to open capture file: %s", file_path);
+            storage_file_free(fhttp.capture_file);
+            furi_record_close(RECORD_STORAGE);
+            fhttp.capture_file = NULL;
+            success = false;
+        }
+    }
+    furi_mutex_release(fhttp.request_mutex);
+    return success;
+}
+
+// State of a replay, shared with the chunk callback
+typedef struct
+{
+    uint32_t bytes_per_second;
+    uint32_t start_tick;
+    FlipperHTTPReplayReport *report;
+} FlipperHTTPReplay;
+
+// Function to sample the heap the worker allocated since the replay started
+static void flipper_http_replay_sample_worker(FlipperHTTPReplayReport *report)
+{
+    size_t held = memmgr_heap_get_thread_memory(fhttp.rx_thread_id);
+    if (held != MEMMGR_HEAP_UNKNOWN)
+    {
+        report->worker_heap_after = held;
+        report->worker_heap_peak = MAX(report->worker_heap_peak, held);
+    }
+}
+
+// Function to push one block of the transcript to the worker
+static bool flipper_http_replay_chunk(const uint8_t *data, size_t length, size_t offset, void *context)
+{
+    FlipperHTTPReplay *replay = (FlipperHTTPReplay *)context;
+    FlipperHTTPReplayReport *report = replay->report;
+    if (replay->bytes_per_second > 0)
+    {
+        // hold the block back until the rate allows it, then drop what does not fit like the RX interrupt
+        uint32_t due_ms = (uint32_t)((uint64_t)offset * 1000 / replay->bytes_per_second);
+        uint32_t elapsed_ms = furi_get_tick() - replay->start_tick;
+        if (due_ms > elapsed_ms)
+        {
+            furi_delay_ms(due_ms - elapsed_ms);
+        }
+        size_t sent = furi_stream_buffer_send(fhttp.flipper_http_stream, data, length, 0);
+        report->dropped_bytes += length - sent;
+        fhttp.rx_dropped += length - sent;
+    }
+    else
+    {
+        furi_stream_buffer_send(fhttp.flipper_http_stream, data, length, FuriWaitForever);
     }
+    furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtRxDone);
+    report->bytes += length;
+    report->heap_min = MIN(report->heap_min, memmgr_get_free_heap());
+    flipper_http_replay_sample_worker(report);
+    return true;
+}
 
-    // Append each byte to the FuriString
-    for (size_t i = 0; i < read_count; i++)
+// Function to replay a captured UART transcript
+/**
+ * @brief      Feed a transcript through the worker as if the board had sent it.
+ * @return     true if the transcript was replayed, false otherwise.
+ * @param      file_path         The transcript (ex. written by flipper_http_capture).
+ * @param      bytes_per_second  The rate to feed it at (0 for as fast as the worker takes it).
+ * @param      bytes_path        Where to save the body of a bytes response (NULL for text responses).
+ * @param      report            Set to the timings, heap use and worker allocations of the replay.
+ * @note       Runs on the calling thread and returns once the worker has drained the transcript.
+ *             The request counters (flipper_http_get_stats) cover the replayed responses.
+ */
+bool flipper_http_replay(const char *file_path, uint32_t bytes_per_second, const char *bytes_path, FlipperHTTPReplayReport *report)
+{
+    if (!file_path || !report || !fhttp.flipper_http_stream || !fhttp.rx_thread)
     {
-        furi_string_push_back(str_result, buffer[i]);
+        FURI_LOG_E(HTTP_TAG, "Invalid arguments or FlipperHTTP is not initialized.");
+        return false;
     }
+    memset(report, 0, sizeof(FlipperHTTPReplayReport));
+    report->heap_before = memmgr_get_free_heap();
+    report->heap_min = report->heap_before;
+    // trace the worker from here so only the replay's allocations are counted
+    memmgr_heap_enable_thread_trace(fhttp.rx_thread_id);
 
-    // Check if there is more data beyond the maximum size
-    char extra_byte;
-    storage_file_read(file, &extra_byte, 1);
+    // the transcript answers a request that was never sent; count it like one
+    if (bytes_path)
+    {
+        snprintf(fhttp.file_path, sizeof(fhttp.file_path), "%s", bytes_path);
+        fhttp.is_bytes_request = true;
+    }
+    flipper_http_start_stats();
+    flipper_http_plan_timeout(FlipperHTTPCommandCustom);
 
-    // Clean up
-    storage_file_close(file);
-    storage_file_free(file);
-    furi_record_close(RECORD_STORAGE);
-    free(buffer);
-    return str_result;
+    FlipperHTTPReplay replay = {bytes_per_second, furi_get_tick(), report};
+    bool success = flipper_http_read_file_chunks(file_path, RX_DMA_CHUNK_SIZE, flipper_http_replay_chunk, &replay);
+
+    // wait for the worker to take the rest (it gives up on a stuck worker after the request timeout)
+    uint32_t wait_start = furi_get_tick();
+    while (!furi_stream_buffer_is_empty(fhttp.flipper_http_stream) && furi_get_tick() - wait_start < TIMEOUT_DURATION_TICKS)
+    {
+        furi_delay_ms(1);
+    }
+    report->elapsed_ms = furi_get_tick() - replay.start_tick;
+    furi_delay_ms(10); // the last block is still being parsed once the buffer is empty
+
+    report->bytes_per_second = report->elapsed_ms ? (uint32_t)((uint64_t)report->bytes * 1000 / report->elapsed_ms) : report->bytes;
+    report->heap_after = memmgr_get_free_heap();
+    report->heap_min = MIN(report->heap_min, report->heap_after);
+    flipper_http_replay_sample_worker(report);
+    memmgr_heap_disable_thread_trace(fhttp.rx_thread_id);
+    report->stack_free = furi_thread_get_stack_space(fhttp.rx_thread_id);
+    fhttp.is_bytes_request = false;
+    return success;
 }
+#endif
 
 // UART worker thread
 /**
@@ -158,70 +1162,109 @@ FuriString *flipper_http_load_from_file(char *file_path)
 int32_t flipper_http_worker(void *context)
 {
     UNUSED(context);
+    static char rx_chunk_buffer[RX_WORKER_CHUNK_SIZE];
     size_t rx_line_pos = 0;
 
     while (1)
     {
         uint32_t events = furi_thread_flags_wait(
-            WorkerEvtStop | WorkerEvtRxDone, FuriFlagWaitAny, FuriWaitForever);
+            WorkerEvtStop | WorkerEvtRxDone | WorkerEvtFileClose | WorkerEvtFileCloseSync | WorkerEvtQueueNext | WorkerEvtTimeout,
+            FuriFlagWaitAny,
+            FuriWaitForever);
         if (events & WorkerEvtStop)
         {
             break;
         }
-        if (events & WorkerEvtRxDone)
+        if (events & (WorkerEvtFileClose | WorkerEvtFileCloseSync))
         {
-            // Continuously read from the stream buffer until it's empty
-            while (!furi_stream_buffer_is_empty(fhttp.flipper_http_stream))
+            // Close the response file from the thread that writes it
+            flipper_http_file_close_now();
+            if (events & WorkerEvtFileCloseSync)
             {
-                // Read one byte at a time
-                char c = 0;
-                size_t received = furi_stream_buffer_receive(fhttp.flipper_http_stream, &c, 1, 0);
-
-                if (received == 0)
+                furi_semaphore_release(fhttp.file_closed);
+            }
+        }
+        if (events & WorkerEvtTimeout)
+        {
+            // Fail the request that timed out, unless its reply completed in the meantime
+            furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+            bool expired = fhttp.timeout_expired;
+            if (expired)
+            {
+                fhttp.request.receiving = FlipperHTTPVerbNone;
+                // an unanswered PING leaves the board INACTIVE, not in error
+                if (fhttp.state != INACTIVE)
                 {
-                    // No more data to read
-                    break;
+                    fhttp.state = ISSUE;
                 }
-
-                // Append the received byte to the file if saving is enabled
-                if (fhttp.save_bytes)
+                fhttp.stats_request.timeouts++;
+            }
+            furi_mutex_release(fhttp.request_mutex);
+            if (expired)
+            {
+                flipper_http_complete_request(false); // this also moves the queue on
+            }
+        }
+        if (events & WorkerEvtQueueNext)
+        {
+            flipper_http_send_next();
+        }
+        if (events & WorkerEvtRxDone)
+        {
+            // Continuously read blocks from the stream buffer until it's empty
+            size_t received = 0;
+            size_t waiting = furi_stream_buffer_bytes_available(fhttp.flipper_http_stream);
+            while ((received = furi_stream_buffer_receive(
+                        fhttp.flipper_http_stream, rx_chunk_buffer, RX_WORKER_CHUNK_SIZE, 0)) > 0)
+            {
+                flipper_http_count_bytes(received, waiting);
+                waiting = 0; // only the first read sees the whole backlog
+#if FLIPPER_HTTP_REPLAY
+                flipper_http_capture_bytes(rx_chunk_buffer, received);
+#endif
+                const char *data = rx_chunk_buffer;
+                while (received > 0)
                 {
-                    // Add byte to the buffer
-                    file_buffer[file_buffer_len++] = c;
-                    // Write to file if buffer is full
-                    if (file_buffer_len >= FILE_BUFFER_SIZE)
+                    // Bytes responses skip line assembly until their END marker
+                    // (checked per span since a completed line may toggle it)
+                    if (fhttp.save_bytes)
                     {
-                        if (!flipper_http_append_to_file(
-                                file_buffer,
-                                file_buffer_len,
-                                fhttp.just_started_bytes,
-                                fhttp.file_path))
-                        {
-                            FURI_LOG_E(HTTP_TAG, "Failed to append data to file");
-                        }
-                        file_buffer_len = 0;
-                        fhttp.just_started_bytes = false;
+                        size_t used = flipper_http_receive_bytes((const uint8_t *)data, received);
+                        data += used;
+                        received -= used;
+                        continue;
                     }
-                }
 
-                // Handle line buffering only if callback is set (text data)
-                if (fhttp.handle_rx_line_cb)
-                {
-                    // Handle line buffering
-                    if (c == '\n' || rx_line_pos >= RX_LINE_BUFFER_SIZE - 1)
-                    {
-                        rx_line_buffer[rx_line_pos] = '\0'; // Null-terminate the line
+                    // Split the block into spans that end on a newline (or the end of the block)
+                    const char *newline = memchr(data, '\n', received);
+                    size_t span_len = newline ? (size_t)(newline - data) + 1 : received;
 
-                        // Invoke the callback with the complete line
-                        fhttp.handle_rx_line_cb(rx_line_buffer, fhttp.callback_context);
-
-                        // Reset the line buffer position
-                        rx_line_pos = 0;
-                    }
-                    else
+                    // Handle line buffering only if callback is set (text data)
+                    if (fhttp.handle_rx_line_cb)
                     {
-                        rx_line_buffer[rx_line_pos++] = c; // Add character to the line buffer
+                        const char *text = data;
+                        size_t text_len = newline ? span_len - 1 : span_len;
+                        while (text_len > 0)
+                        {
+                            // Flush the line early if the line buffer is full
+                            if (rx_line_pos >= RX_LINE_BUFFER_SIZE - 1)
+                            {
+                                flipper_http_emit_line(&rx_line_pos);
+                            }
+                            size_t copy_len = MIN(text_len, (size_t)(RX_LINE_BUFFER_SIZE - 1 - rx_line_pos));
+                            memcpy(&rx_line_buffer[rx_line_pos], text, copy_len);
+                            rx_line_pos += copy_len;
+                            text += copy_len;
+                            text_len -= copy_len;
+                        }
+                        if (newline)
+                        {
+                            flipper_http_emit_line(&rx_line_pos);
+                        }
                     }
+
+                    data += span_len;
+                    received -= span_len;
                 }
             }
         }
@@ -231,24 +1274,45 @@ int32_t flipper_http_worker(void *context)
 }
 // Timer callback function
 /**
- * @brief      Callback function for the GET timeout timer.
- * @return     0
+ * @brief      Watchdog tick checking the timeout budgets of the request in flight.
+ * @return     void
  * @param      context   The context to pass to the callback.
- * @note       This function will be called when the GET request times out.
+ * @note       Fails the request once its connect, idle or total budget is used up.
  */
 void get_timeout_timer_callback(void *context)
 {
     UNUSED(context);
-    FURI_LOG_E(HTTP_TAG, "Timeout reached: 2 seconds without receiving the end.");
+    if (!fhttp.timeout_armed)
+    {
+        return;
+    }
 
-    // Reset the state
-    fhttp.started_receiving_get = false;
-    fhttp.started_receiving_post = false;
-    fhttp.started_receiving_put = false;
-    fhttp.started_receiving_delete = false;
+    // Check the budgets against the send time and the last received byte
+    uint32_t now = furi_get_tick();
+    uint32_t last_activity = fhttp.last_activity_tick;
+    const char *expired = NULL;
+    if (fhttp.timeout.total_ms != 0 && now - fhttp.request_start_tick > fhttp.timeout.total_ms)
+    {
+        expired = "total";
+    }
+    else if (last_activity == 0 && now - fhttp.request_start_tick > fhttp.timeout.connect_ms)
+    {
+        expired = "connect";
+    }
+    else if (last_activity != 0 && now - last_activity > fhttp.timeout.idle_ms)
+    {
+        expired = "idle";
+    }
+    if (!expired)
+    {
+        return;
+    }
+    FURI_LOG_E(HTTP_TAG, "Timeout reached: %s budget of the request used up.", expired);
+    fhttp.timeout_armed = false; // report it once
 
-    // Update UART state
-    fhttp.state = ISSUE;
+    // The request belongs to the worker: let it close the response file and fail it
+    fhttp.timeout_expired = true;
+    furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtFileClose | WorkerEvtTimeout);
 }
 
 // UART RX Handler Callback (Interrupt Context)
@@ -268,9 +1332,154 @@ void _flipper_http_rx_callback(
     UNUSED(context);
     if (event == FuriHalSerialRxEventData)
     {
-        uint8_t data = furi_hal_serial_async_rx(handle);
-        furi_stream_buffer_send(fhttp.flipper_http_stream, &data, 1, 0);
-        furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtRxDone);
+        uint8_t data = furi_hal_serial_async_rx(handle);
+        if (furi_stream_buffer_send(fhttp.flipper_http_stream, &data, 1, 0) == 0)
+        {
+            fhttp.rx_dropped++;
+        }
+        furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtRxDone);
+    }
+}
+
+// UART DMA RX Handler Callback (Interrupt Context)
+/**
+ * @brief      A private callback function to handle batched DMA data asynchronously.
+ * @return     void
+ * @param      handle    The UART handle.
+ * @param      event     The event type (data on half/full transfer, idle on idle line).
+ * @param      data_len  The number of bytes waiting in the DMA buffer.
+ * @param      context   The context to pass to the callback.
+ * @note       The worker is signaled once per chunk instead of once per byte.
+ */
+void _flipper_http_rx_dma_callback(
+    FuriHalSerialHandle *handle,
+    FuriHalSerialRxEvent event,
+    size_t data_len,
+    void *context)
+{
+    UNUSED(context);
+    if (event & (FuriHalSerialRxEventData | FuriHalSerialRxEventIdle))
+    {
+        uint8_t data[RX_DMA_CHUNK_SIZE];
+        while (data_len > 0)
+        {
+            size_t received = furi_hal_serial_dma_rx(handle, data, MIN(data_len, sizeof(data)));
+            if (received == 0)
+            {
+                break;
+            }
+            fhttp.rx_dropped += received - furi_stream_buffer_send(fhttp.flipper_http_stream, data, received, 0);
+            data_len -= received;
+        }
+        furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtRxDone);
+    }
+}
+
+// Function to free whatever flipper_http_init has set up so far
+static void flipper_http_release()
+{
+    // Make sure the timeout cannot fire while tearing down
+    flipper_http_disarm_timeout();
+#if FLIPPER_HTTP_REPLAY
+    flipper_http_capture(NULL);
+#endif
+
+    if (fhttp.serial_handle)
+    {
+#if FLIPPER_HTTP_BAUDRATE_NEGOTIATION
+        // Put the board back on the default baudrate for the next app
+        if (fhttp.baudrate != BAUDRATE)
+        {
+            char command[64];
+            int length = snprintf(command, sizeof(command), "[UART/BAUDRATE]{\"baudrate\":%lu}\n", (uint32_t)BAUDRATE);
+            furi_hal_serial_tx(fhttp.serial_handle, (const uint8_t *)command, length);
+            furi_hal_serial_tx_wait_complete(fhttp.serial_handle);
+            fhttp.baudrate = BAUDRATE;
+        }
+#endif
+
+        // Stop asynchronous RX
+#if UART_RX_DMA
+        furi_hal_serial_dma_rx_stop(fhttp.serial_handle);
+#else
+        furi_hal_serial_async_rx_stop(fhttp.serial_handle);
+#endif
+
+        // Deinitialize and release the serial handle
+        furi_hal_serial_disable_direction(fhttp.serial_handle, FuriHalSerialDirectionRx);
+        furi_hal_serial_deinit(fhttp.serial_handle);
+        furi_hal_serial_control_release(fhttp.serial_handle);
+        fhttp.serial_handle = NULL;
+    }
+
+    if (fhttp.rx_thread)
+    {
+        // Signal the worker thread to stop and wait for it to finish
+        furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtStop);
+        furi_thread_join(fhttp.rx_thread);
+        furi_thread_free(fhttp.rx_thread);
+        fhttp.rx_thread = NULL;
+    }
+
+    // Close the response file if a request was interrupted
+    flipper_http_file_close();
+
+    // Free the stream buffer
+    if (fhttp.flipper_http_stream)
+    {
+        furi_stream_buffer_free(fhttp.flipper_http_stream);
+        fhttp.flipper_http_stream = NULL;
+    }
+
+    // Free the timer
+    if (fhttp.get_timeout_timer)
+    {
+        furi_timer_free(fhttp.get_timeout_timer);
+        fhttp.get_timeout_timer = NULL;
+    }
+
+    // Fail the command in flight and those still waiting in the queue
+    if (fhttp.request.on_complete)
+    {
+        fhttp.request.on_complete(fhttp.request.id, false, NULL, fhttp.request.on_complete_context);
+    }
+    if (fhttp.request_queue)
+    {
+        FlipperHTTPQueuedCommand pending;
+        while (furi_message_queue_get(fhttp.request_queue, &pending, 0) == FuriStatusOk)
+        {
+            if (pending.on_complete)
+            {
+                pending.on_complete(pending.id, false, NULL, pending.on_complete_context);
+            }
+        }
+        furi_message_queue_free(fhttp.request_queue);
+        fhttp.request_queue = NULL;
+    }
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_free(fhttp.request_mutex);
+        fhttp.request_mutex = NULL;
+    }
+    memset(&fhttp.request, 0, sizeof(fhttp.request));
+
+    // Free the response semaphore
+    if (fhttp.response_done)
+    {
+        furi_semaphore_free(fhttp.response_done);
+        fhttp.response_done = NULL;
+    }
+    if (fhttp.file_closed)
+    {
+        furi_semaphore_free(fhttp.file_closed);
+        fhttp.file_closed = NULL;
+    }
+
+    // Free the last response
+    if (fhttp.last_response)
+    {
+        free(fhttp.last_response);
+        fhttp.last_response = NULL;
     }
 }
 
@@ -294,93 +1503,132 @@ bool flipper_http_init(FlipperHTTP_Callback callback, void *context)
         FURI_LOG_E(HTTP_TAG, "Invalid callback provided to flipper_http_init.");
         return false;
     }
+    if (fhttp.serial_handle)
+    {
+        FURI_LOG_I(HTTP_TAG, "UART is already initialized.");
+        return true;
+    }
+
+    // handle when the UART control is busy to avoid furi_check failed
+    if (furi_hal_serial_control_is_busy(UART_CH))
+    {
+        FURI_LOG_E(HTTP_TAG, "UART control is busy.");
+        return false;
+    }
+
+    fhttp.handle_rx_line_cb = callback;
+    fhttp.callback_context = context;
+
+    // Allocate everything the worker and the RX side use before any data can arrive
     fhttp.flipper_http_stream = furi_stream_buffer_alloc(RX_BUF_SIZE, 1);
     if (!fhttp.flipper_http_stream)
     {
         FURI_LOG_E(HTTP_TAG, "Failed to allocate UART stream buffer.");
+        flipper_http_release();
+        return false;
+    }
+
+    fhttp.last_response = (char *)malloc(RX_BUF_SIZE);
+    if (!fhttp.last_response)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to allocate memory for last_response.");
+        flipper_http_release();
+        return false;
+    }
+    fhttp.last_response[0] = '\0';
+
+    // Binary semaphore signalled each time a response completes
+    fhttp.response_done = furi_semaphore_alloc(1, 0);
+    if (!fhttp.response_done)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to allocate the response semaphore.");
+        flipper_http_release();
+        return false;
+    }
+
+    // Acknowledges a file close handed to the worker by another thread
+    fhttp.file_closed = furi_semaphore_alloc(1, 0);
+    if (!fhttp.file_closed)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to allocate the file close semaphore.");
+        flipper_http_release();
+        return false;
+    }
+
+    // Request record and the queue of commands waiting behind it
+    memset(&fhttp.request, 0, sizeof(fhttp.request));
+    memset(&fhttp.stats_request, 0, sizeof(fhttp.stats_request));
+    memset(&fhttp.stats_last, 0, sizeof(fhttp.stats_last));
+    memset(&fhttp.stats_total, 0, sizeof(fhttp.stats_total));
+    fhttp.request_start_tick = 0;
+    fhttp.rx_dropped = 0;
+    fhttp.rx_dropped_at_start = 0;
+    fhttp.request_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    fhttp.request_queue = furi_message_queue_alloc(REQUEST_QUEUE_SIZE, sizeof(FlipperHTTPQueuedCommand));
+    if (!fhttp.request_mutex || !fhttp.request_queue)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to allocate the request queue.");
+        flipper_http_release();
+        return false;
+    }
+
+    // Allocate the timer for handling timeouts
+    fhttp.get_timeout_timer = furi_timer_alloc(
+        get_timeout_timer_callback, // Callback function
+        FuriTimerTypePeriodic,      // Watchdog tick, armed while a request is in flight
+        &fhttp                      // Context passed to callback
+    );
+    if (!fhttp.get_timeout_timer)
+    {
+        FURI_LOG_E(HTTP_TAG, "Failed to allocate HTTP request timeout timer.");
+        flipper_http_release();
         return false;
     }
 
+    // Set the timer thread priority if needed
+    furi_timer_set_thread_priority(FuriTimerThreadPriorityElevated);
+
     fhttp.rx_thread = furi_thread_alloc();
     if (!fhttp.rx_thread)
     {
         FURI_LOG_E(HTTP_TAG, "Failed to allocate UART thread.");
-        furi_stream_buffer_free(fhttp.flipper_http_stream);
+        flipper_http_release();
         return false;
     }
 
     furi_thread_set_name(fhttp.rx_thread, "FlipperHTTP_RxThread");
-    furi_thread_set_stack_size(fhttp.rx_thread, 1024);
+    furi_thread_set_stack_size(fhttp.rx_thread, RX_THREAD_STACK_SIZE);
     furi_thread_set_context(fhttp.rx_thread, &fhttp);
     furi_thread_set_callback(fhttp.rx_thread, flipper_http_worker);
 
-    fhttp.handle_rx_line_cb = callback;
-    fhttp.callback_context = context;
-
     furi_thread_start(fhttp.rx_thread);
     fhttp.rx_thread_id = furi_thread_get_id(fhttp.rx_thread);
 
-    // handle when the UART control is busy to avoid furi_check failed
-    if (furi_hal_serial_control_is_busy(UART_CH))
-    {
-        FURI_LOG_E(HTTP_TAG, "UART control is busy.");
-        return false;
-    }
-
     fhttp.serial_handle = furi_hal_serial_control_acquire(UART_CH);
     if (!fhttp.serial_handle)
     {
         FURI_LOG_E(HTTP_TAG, "Failed to acquire UART control - handle is NULL");
-        // Cleanup resources
-        furi_thread_free(fhttp.rx_thread);
-        furi_stream_buffer_free(fhttp.flipper_http_stream);
+        flipper_http_release();
         return false;
     }
 
     // Initialize UART with acquired handle
     furi_hal_serial_init(fhttp.serial_handle, BAUDRATE);
+    fhttp.baudrate = BAUDRATE;
 
     // Enable RX direction
     furi_hal_serial_enable_direction(fhttp.serial_handle, FuriHalSerialDirectionRx);
 
     // Start asynchronous RX with the callback
+#if UART_RX_DMA
+    furi_hal_serial_dma_rx_start(fhttp.serial_handle, _flipper_http_rx_dma_callback, &fhttp, false);
+#else
     furi_hal_serial_async_rx_start(fhttp.serial_handle, _flipper_http_rx_callback, &fhttp, false);
+#endif
 
     // Wait for the TX to complete to ensure UART is ready
     furi_hal_serial_tx_wait_complete(fhttp.serial_handle);
 
-    // Allocate the timer for handling timeouts
-    fhttp.get_timeout_timer = furi_timer_alloc(
-        get_timeout_timer_callback, // Callback function
-        FuriTimerTypeOnce,          // One-shot timer
-        &fhttp                      // Context passed to callback
-    );
-
-    if (!fhttp.get_timeout_timer)
-    {
-        FURI_LOG_E(HTTP_TAG, "Failed to allocate HTTP request timeout timer.");
-        // Cleanup resources
-        furi_hal_serial_async_rx_stop(fhttp.serial_handle);
-        furi_hal_serial_disable_direction(fhttp.serial_handle, FuriHalSerialDirectionRx);
-        furi_hal_serial_control_release(fhttp.serial_handle);
-        furi_hal_serial_deinit(fhttp.serial_handle);
-        furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtStop);
-        furi_thread_join(fhttp.rx_thread);
-        furi_thread_free(fhttp.rx_thread);
-        furi_stream_buffer_free(fhttp.flipper_http_stream);
-        return false;
-    }
-
-    // Set the timer thread priority if needed
-    furi_timer_set_thread_priority(FuriTimerThreadPriorityElevated);
-
-    fhttp.last_response = (char *)malloc(RX_BUF_SIZE);
-    if (!fhttp.last_response)
-    {
-        FURI_LOG_E(HTTP_TAG, "Failed to allocate memory for last_response.");
-        return false;
-    }
-
     // FURI_LOG_I(HTTP_TAG, "UART initialized successfully.");
     return true;
 }
@@ -398,49 +1646,146 @@ void flipper_http_deinit()
         FURI_LOG_E(HTTP_TAG, "UART handle is NULL. Already deinitialized?");
         return;
     }
-    // Stop asynchronous RX
-    furi_hal_serial_async_rx_stop(fhttp.serial_handle);
+    flipper_http_release();
 
-    // Release and deinitialize the serial handle
-    furi_hal_serial_disable_direction(fhttp.serial_handle, FuriHalSerialDirectionRx);
-    furi_hal_serial_control_release(fhttp.serial_handle);
-    furi_hal_serial_deinit(fhttp.serial_handle);
+    // FURI_LOG_I("FlipperHTTP", "UART deinitialized successfully.");
+}
 
-    // Signal the worker thread to stop
-    furi_thread_flags_set(fhttp.rx_thread_id, WorkerEvtStop);
-    // Wait for the thread to finish
-    furi_thread_join(fhttp.rx_thread);
-    // Free the thread resources
-    furi_thread_free(fhttp.rx_thread);
+// Function to start the app-lifetime session
+/**
+ * @brief      Start a session that keeps the UART open across screens.
+ * @return     true if the UART is open, false otherwise.
+ * @param      callback  The callback function to handle received data (ex. flipper_http_rx_callback).
+ * @param      context   The context to pass to the callback.
+ * @note       The callback and context are kept so flipper_http_session_ensure can reconnect.
+ */
+bool flipper_http_session_start(FlipperHTTP_Callback callback, void *context)
+{
+    fhttp.session_callback = callback;
+    fhttp.session_context = context;
+    return flipper_http_init(callback, context);
+}
 
-    // Free the stream buffer
-    furi_stream_buffer_free(fhttp.flipper_http_stream);
+// Function to make sure the session's UART is open
+/**
+ * @brief      Reuse the open session, reconnecting only if the port was lost.
+ * @return     true if the UART is open, false otherwise.
+ * @note       Call before each action instead of flipper_http_init.
+ */
+bool flipper_http_session_ensure()
+{
+    if (fhttp.serial_handle)
+    {
+        return true;
+    }
+    if (!fhttp.session_callback)
+    {
+        FURI_LOG_E(HTTP_TAG, "No FlipperHTTP session was started.");
+        return false;
+    }
+    FURI_LOG_I(HTTP_TAG, "Reconnecting the FlipperHTTP session.");
+    return flipper_http_init(fhttp.session_callback, fhttp.session_context);
+}
 
-    // Free the timer
-    if (fhttp.get_timeout_timer)
+// Function to end the app-lifetime session
+/**
+ * @brief      Close the session's UART and forget its callback.
+ * @return     void
+ */
+void flipper_http_session_end()
+{
+    if (fhttp.serial_handle || fhttp.rx_thread)
     {
-        furi_timer_free(fhttp.get_timeout_timer);
-        fhttp.get_timeout_timer = NULL;
+        flipper_http_release();
     }
+    fhttp.session_callback = NULL;
+    fhttp.session_context = NULL;
+}
 
-    // Free the last response
-    if (fhttp.last_response)
+// Function to send one command line over UART
+/**
+ * @brief      Append the newline to a command line and send it.
+ * @return     true if the line was sent, false otherwise.
+ * @param      send_buffer  The line, in a buffer with room for two more bytes.
+ * @param      length       The length of the line.
+ * @param      command      The table entry of the line (FlipperHTTPCommandCustom if none).
+ * @param      queued       The line is the queued request being sent, not a direct send.
+ * @note       Direct sends are refused while a queued request or a response body is in flight.
+ */
+static bool flipper_http_transmit(char *send_buffer, size_t length, FlipperHTTPCommand command, bool queued)
+{
+    if (fhttp.state == INACTIVE && (command == FlipperHTTPCommandCustom || !flipper_http_commands[command].when_inactive))
     {
-        free(fhttp.last_response);
-        fhttp.last_response = NULL;
+        FURI_LOG_E("FlipperHTTP", "Cannot send data while INACTIVE.");
+        if (fhttp.last_response)
+        {
+            snprintf(fhttp.last_response, RX_BUF_SIZE, "%s", "Cannot send data while INACTIVE.");
+        }
+        return false;
+    }
+    if (command < FlipperHTTPCommandCustom && flipper_http_commands[command].kind == FlipperHTTPReplyBytes && !fhttp.is_bytes_request)
+    {
+        FURI_LOG_W("FlipperHTTP", "%s replies with bytes, set is_bytes_request to save them.", flipper_http_commands[command].tag);
     }
 
-    // FURI_LOG_I("FlipperHTTP", "UART deinitialized successfully.");
+    send_buffer[length] = '\n';     // Append newline
+    send_buffer[length + 1] = '\0'; // Null-terminate
+
+    // Drop a completion left over from an earlier response
+    if (fhttp.response_done)
+    {
+        while (furi_semaphore_acquire(fhttp.response_done, 0) == FuriStatusOk)
+            ;
+    }
+
+    // a direct line would take over the reply of the queued request in flight, whose
+    // completion would then be credited to it
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_acquire(fhttp.request_mutex, FuriWaitForever);
+    }
+    if (!queued && (fhttp.request.id != 0 || fhttp.request.receiving != FlipperHTTPVerbNone))
+    {
+        if (fhttp.request_mutex)
+        {
+            furi_mutex_release(fhttp.request_mutex);
+        }
+        FURI_LOG_E("FlipperHTTP", "Cannot send data while a request is in flight.");
+        if (fhttp.last_response)
+        {
+            snprintf(fhttp.last_response, RX_BUF_SIZE, "%s", "Cannot send data while a request is in flight.");
+        }
+        return false;
+    }
+
+    // a PING leaves the state INACTIVE for its PONG to make IDLE; set before the line goes
+    // out so a PONG arriving right away is not missed
+    fhttp.state = command == FlipperHTTPCommandPing ? INACTIVE : SENDING;
+    fhttp.expected_line = command < FlipperHTTPCommandCustom ? flipper_http_commands[command].reply : FlipperHTTPLinePayload;
+    flipper_http_start_stats();
+    flipper_http_plan_timeout(command);
+    // armed before the write: a reply completing right away disarms it for good, and a
+    // silent board completes the command through the timeout
+    flipper_http_arm_timeout();
+    furi_hal_serial_tx(fhttp.serial_handle, (const uint8_t *)send_buffer, length + 1);
+    if (fhttp.request_mutex)
+    {
+        furi_mutex_release(fhttp.request_mutex);
+    }
+
+    // Uncomment below line to log the data sent over UART
+    // FURI_LOG_I("FlipperHTTP", "Sent data over UART: %s", send_buffer);
+    return true;
 }
 
-// Function to send data over UART with newline termination
+// Function to send one line over UART, directly or as the queued request
 /**
  * @brief      Send data over UART with newline termination.
  * @return     true if the data was sent successfully, false otherwise.
- * @param      data  The data to send over UART.
- * @note       The data will be sent over UART with a newline character appended.
+ * @param      data    The data to send over UART.
+ * @param      queued  The data is the queued request being sent, not a direct send.
  */
-bool flipper_http_send_data(const char *data)
+static bool flipper_http_send_line(const char *data, bool queued)
 {
     size_t data_length = strlen(data);
     if (data_length == 0)
@@ -458,24 +1803,77 @@ bool flipper_http_send_data(const char *data)
     }
 
     char send_buffer[257]; // 256 + 1 for safety
-    strncpy(send_buffer, data, 256);
-    send_buffer[data_length] = '\n';     // Append newline
-    send_buffer[data_length + 1] = '\0'; // Null-terminate
+    memcpy(send_buffer, data, data_length);
+    return flipper_http_transmit(send_buffer, data_length, flipper_http_find_command(data), queued);
+}
+
+// Function to send data over UART with newline termination
+/**
+ * @brief      Send data over UART with newline termination.
+ * @return     true if the data was sent successfully, false otherwise.
+ * @param      data  The data to send over UART.
+ * @note       The data will be sent over UART with a newline character appended.
+ *             It is refused while a queued request is in flight, use flipper_http_enqueue to send after it.
+ */
+bool flipper_http_send_data(const char *data)
+{
+    return flipper_http_send_line(data, false);
+}
 
-    if (fhttp.state == INACTIVE && ((strstr(send_buffer, "[PING]") == NULL) &&
-                                    (strstr(send_buffer, "[WIFI/CONNECT]") == NULL)))
+// Function to build a command from the command table and send it
+/**
+ * @brief      Send a command with its arguments formatted after its tag.
+ * @return     true if the command was sent, false otherwise.
+ * @param      command  The command to send.
+ * @param      format   The printf format of the arguments (NULL if the command takes none).
+ * @note       The line is built straight into the send buffer, the tag is not looked up again.
+ */
+static bool flipper_http_send_command(FlipperHTTPCommand command, const char *format, ...)
+{
+    char send_buffer[257]; // 256 + 1 for safety
+    size_t length = flipper_http_commands[command].length;
+    memcpy(send_buffer, flipper_http_commands[command].tag, length);
+    if (format)
+    {
+        va_list args;
+        va_start(args, format);
+        int ret = vsnprintf(send_buffer + length, 256 - length, format, args);
+        va_end(args);
+        if (ret < 0 || length + ret >= 256)
+        {
+            FURI_LOG_E("FlipperHTTP", "Failed to format %s command.", flipper_http_commands[command].tag);
+            return false;
+        }
+        length += ret;
+    }
+    if (!flipper_http_transmit(send_buffer, length, command, false))
     {
-        FURI_LOG_E("FlipperHTTP", "Cannot send data while INACTIVE.");
-        fhttp.last_response = "Cannot send data while INACTIVE.";
+        FURI_LOG_E("FlipperHTTP", "Failed to send %s command.", flipper_http_commands[command].tag);
         return false;
     }
+    return true;
+}
 
-    fhttp.state = SENDING;
-    furi_hal_serial_tx(fhttp.serial_handle, (const uint8_t *)send_buffer, send_length);
-
-    // Uncomment below line to log the data sent over UART
-    // FURI_LOG_I("FlipperHTTP", "Sent data over UART: %s", send_buffer);
-    // fhttp.state = IDLE;
+// Function to wait for the response to the last command
+/**
+ * @brief      Block until the response to the last command completes or the wait times out.
+ * @return     true if the response completed, false if nothing arrived in time.
+ * @param      timeout_ms  The longest time to wait, in milliseconds.
+ * @note       A response completes on its END marker, a single-line reply, an error or the request timeout.
+ *             Check fhttp.state for ISSUE to tell a failed response from a good one.
+ */
+bool flipper_http_wait_response(uint32_t timeout_ms)
+{
+    if (!fhttp.response_done)
+    {
+        FURI_LOG_E(HTTP_TAG, "FlipperHTTP is not initialized.");
+        return false;
+    }
+    if (furi_semaphore_acquire(fhttp.response_done, furi_ms_to_ticks(timeout_ms)) != FuriStatusOk)
+    {
+        FURI_LOG_E(HTTP_TAG, "No response within %lu ms.", timeout_ms);
+        return false;
+    }
     return true;
 }
 
@@ -489,17 +1887,93 @@ bool flipper_http_send_data(const char *data)
  */
 bool flipper_http_ping()
 {
-    const char *command = "[PING]";
-    if (!flipper_http_send_data(command))
+    // the state goes INACTIVE as the PING is sent, to be made IDLE if PONG is received
+    // The response will be handled asynchronously via the callback
+    return flipper_http_send_command(FlipperHTTPCommandPing, NULL);
+}
+
+// Function to send a PING and wait for the PONG
+/**
+ * @brief      Send a PING and wait until the PONG arrives or the wait times out.
+ * @return     true if the Wifi Dev Board answered, false otherwise.
+ * @param      timeout_ms  The longest time to wait, in milliseconds.
+ */
+bool flipper_http_ping_wait(uint32_t timeout_ms)
+{
+    if (!flipper_http_ping())
     {
-        FURI_LOG_E("FlipperHTTP", "Failed to send PING command.");
         return false;
     }
-    // set state as INACTIVE to be made IDLE if PONG is received
-    fhttp.state = INACTIVE;
-    // The response will be handled asynchronously via the callback
-    return true;
+    // the PONG turns INACTIVE into IDLE; any other line keeps waiting
+    uint32_t deadline = furi_get_tick() + furi_ms_to_ticks(timeout_ms);
+    while (fhttp.state == INACTIVE && furi_get_tick() < deadline)
+    {
+        flipper_http_wait_response(deadline - furi_get_tick());
+    }
+    return fhttp.state != INACTIVE;
+}
+
+#if FLIPPER_HTTP_BAUDRATE_NEGOTIATION
+// Function to tell the board which baudrate to switch to
+static bool flipper_http_send_baudrate(uint32_t baudrate)
+{
+    return flipper_http_send_command(FlipperHTTPCommandBaudrate, "{\"baudrate\":%lu}", baudrate);
+}
+
+// Function to negotiate a faster UART baudrate
+/**
+ * @brief      Ask the Wifi Dev Board to switch baudrate, then confirm the link with a PING.
+ * @return     true if the link now runs at the requested baudrate, false if it stayed (or went back) at the old one.
+ * @param      baudrate  The baudrate to switch to (ex. BAUDRATE_HIGH).
+ * @note       Boards acknowledge [UART/BAUDRATE] with [SUCCESS] at the old rate and then switch.
+ *             Flashes that do not know the command reply with an error (or nothing) and keep the old rate.
+ *             If the confirm PING fails, both sides fall back to the old rate.
+ *             The board is switched back to BAUDRATE before the UART is released.
+ */
+bool flipper_http_negotiate_baudrate(uint32_t baudrate)
+{
+    if (!fhttp.serial_handle)
+    {
+        FURI_LOG_E(HTTP_TAG, "UART is not initialized.");
+        return false;
+    }
+    if (baudrate == fhttp.baudrate)
+    {
+        return true;
+    }
+
+    uint32_t previous = fhttp.baudrate;
+    if (!flipper_http_send_baudrate(baudrate))
+    {
+        return false;
+    }
+    if (!flipper_http_wait_response(BAUDRATE_CONFIRM_MS) ||
+        strncmp(fhttp.last_response, "[SUCCESS]", strlen("[SUCCESS]")) != 0)
+    {
+        // older flashes do not know the command, stay where we are
+        FURI_LOG_I(HTTP_TAG, "Board kept %lu baud.", previous);
+        fhttp.state = IDLE;
+        return false;
+    }
+
+    // switch only once the command has left at the old rate
+    furi_hal_serial_tx_wait_complete(fhttp.serial_handle);
+    furi_hal_serial_set_br(fhttp.serial_handle, baudrate);
+    fhttp.baudrate = baudrate;
+    if (flipper_http_ping_wait(BAUDRATE_CONFIRM_MS))
+    {
+        FURI_LOG_I(HTTP_TAG, "UART running at %lu baud.", baudrate);
+        return true;
+    }
+
+    // no PONG at the new rate: the board falls back on its own, follow it
+    FURI_LOG_E(HTTP_TAG, "No PONG at %lu baud, falling back to %lu.", baudrate, previous);
+    furi_hal_serial_set_br(fhttp.serial_handle, previous);
+    fhttp.baudrate = previous;
+    flipper_http_ping_wait(BAUDRATE_CONFIRM_MS);
+    return false;
 }
+#endif
 
 // Function to list available commands
 /**
@@ -509,15 +1983,8 @@ bool flipper_http_ping()
  */
 bool flipper_http_list_commands()
 {
-    const char *command = "[LIST]";
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send LIST command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandList, NULL);
 }
 
 // Function to turn on the LED
@@ -528,15 +1995,8 @@ bool flipper_http_list_commands()
  */
 bool flipper_http_led_on()
 {
-    const char *command = "[LED/ON]";
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send LED ON command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandLedOn, NULL);
 }
 
 // Function to turn off the LED
@@ -547,15 +2007,8 @@ bool flipper_http_led_on()
  */
 bool flipper_http_led_off()
 {
-    const char *command = "[LED/OFF]";
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send LED OFF command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandLedOff, NULL);
 }
 
 // Function to parse JSON data
@@ -574,23 +2027,8 @@ bool flipper_http_parse_json(const char *key, const char *json_data)
         return false;
     }
 
-    char buffer[256];
-    int ret =
-        snprintf(buffer, sizeof(buffer), "[PARSE]{\"key\":\"%s\",\"json\":%s}", key, json_data);
-    if (ret < 0 || ret >= (int)sizeof(buffer))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format JSON parse command.");
-        return false;
-    }
-
-    if (!flipper_http_send_data(buffer))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send JSON parse command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandParse, "{\"key\":\"%s\",\"json\":%s}", key, json_data);
 }
 
 // Function to parse JSON array data
@@ -610,62 +2048,20 @@ bool flipper_http_parse_json_array(const char *key, int index, const char *json_
         return false;
     }
 
-    char buffer[256];
-    int ret = snprintf(
-        buffer,
-        sizeof(buffer),
-        "[PARSE/ARRAY]{\"key\":\"%s\",\"index\":%d,\"json\":%s}",
-        key,
-        index,
-        json_data);
-    if (ret < 0 || ret >= (int)sizeof(buffer))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format JSON parse array command.");
-        return false;
-    }
-
-    if (!flipper_http_send_data(buffer))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send JSON parse array command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandParseArray, "{\"key\":\"%s\",\"index\":%d,\"json\":%s}", key, index, json_data);
 }
 
 // Function to scan for WiFi networks
 /**
  * @brief      Send a command to scan for WiFi networks.
  * @return     true if the request was successful, false otherwise.
- * @note       The received data will be handled asynchronously via the callback.
+ * @note       The reply is handed to the hook set with flipper_http_set_line_callback as it arrives.
  */
 bool flipper_http_scan_wifi()
 {
-    // custom for FlipWiFi app
-    fhttp.just_started_get = true;
-
-    // ensure the data folder exists
-
-    snprintf(
-        fhttp.file_path,
-        sizeof(fhttp.file_path),
-        STORAGE_EXT_PATH_PREFIX "/apps_data/flip_wifi/data/scan.txt");
-
-    // ensure the file is empty
-    Storage *storage = furi_record_open(RECORD_STORAGE);
-    storage_simply_remove_recursive(storage, fhttp.file_path);
-    furi_record_close(RECORD_STORAGE);
-
-    fhttp.save_received_data = true;
-
-    if (!flipper_http_send_data("[WIFI/SCAN]"))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send WiFi scan command.");
-        return false;
-    }
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandWifiScan, NULL);
 }
 
 // Function to save WiFi settings (returns true if successful)
@@ -683,25 +2079,13 @@ bool flipper_http_save_wifi(const char *ssid, const char *password)
     }
 
     // custom for FlipWiFi app
-    fhttp.just_started_get = true;
-
-    char buffer[256];
-    int ret = snprintf(
-        buffer, sizeof(buffer), "[WIFI/SAVE]{\"ssid\":\"%s\",\"password\":\"%s\"}", ssid, password);
-    if (ret < 0 || ret >= (int)sizeof(buffer))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format WiFi save command.");
-        return false;
-    }
+    fhttp.request.start_new_file = true;
 
-    if (!flipper_http_send_data(buffer))
+    if (!flipper_http_send_command(FlipperHTTPCommandWifiSave, "{\"ssid\":\"%s\",\"password\":\"%s\"}", ssid, password))
     {
-        FURI_LOG_E("FlipperHTTP", "Failed to send WiFi save command.");
         return false;
     }
 
-    fhttp.state = RECEIVING;
-
     // The response will be handled asynchronously via the callback
     return true;
 }
@@ -714,14 +2098,8 @@ bool flipper_http_save_wifi(const char *ssid, const char *password)
  */
 bool flipper_http_ip_address()
 {
-    if (!flipper_http_send_data("[IP/ADDRESS]"))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send IP address command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandIpAddress, NULL);
 }
 
 // Function to get IP address of the connected WiFi network
@@ -732,15 +2110,8 @@ bool flipper_http_ip_address()
  */
 bool flipper_http_ip_wifi()
 {
-    const char *command = "[WIFI/IP]";
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send WiFi IP command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandWifiIp, NULL);
 }
 
 // Function to disconnect from WiFi (returns true if successful)
@@ -751,14 +2122,8 @@ bool flipper_http_ip_wifi()
  */
 bool flipper_http_disconnect_wifi()
 {
-    if (!flipper_http_send_data("[WIFI/DISCONNECT]"))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send WiFi disconnect command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandWifiDisconnect, NULL);
 }
 
 // Function to connect to WiFi (returns true if successful)
@@ -769,14 +2134,8 @@ bool flipper_http_disconnect_wifi()
  */
 bool flipper_http_connect_wifi()
 {
-    if (!flipper_http_send_data("[WIFI/CONNECT]"))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send WiFi connect command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandWifiConnect, NULL);
 }
 
 // Function to send a GET request
@@ -794,24 +2153,8 @@ bool flipper_http_get_request(const char *url)
         return false;
     }
 
-    // Prepare GET request command
-    char command[256];
-    int ret = snprintf(command, sizeof(command), "[GET]%s", url);
-    if (ret < 0 || ret >= (int)sizeof(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format GET request command.");
-        return false;
-    }
-
-    // Send GET request via UART
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send GET request command.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandGet, "%s", url);
 }
 // Function to send a GET request with headers
 /**
@@ -825,30 +2168,12 @@ bool flipper_http_get_request_with_headers(const char *url, const char *headers)
 {
     if (!url || !headers)
     {
-        FURI_LOG_E(
-            "FlipperHTTP", "Invalid arguments provided to flipper_http_get_request_with_headers.");
-        return false;
-    }
-
-    // Prepare GET request command with headers
-    char command[256];
-    int ret = snprintf(
-        command, sizeof(command), "[GET/HTTP]{\"url\":\"%s\",\"headers\":%s}", url, headers);
-    if (ret < 0 || ret >= (int)sizeof(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format GET request command with headers.");
-        return false;
-    }
-
-    // Send GET request via UART
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send GET request command with headers.");
+        FURI_LOG_E("FlipperHTTP", "Invalid arguments provided to flipper_http_get_request_with_headers.");
         return false;
     }
 
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandGetHttp, "{\"url\":\"%s\",\"headers\":%s}", url, headers);
 }
 // Function to send a GET request with headers and return bytes
 /**
@@ -866,25 +2191,8 @@ bool flipper_http_get_request_bytes(const char *url, const char *headers)
         return false;
     }
 
-    // Prepare GET request command with headers
-    char command[256];
-    int ret = snprintf(
-        command, sizeof(command), "[GET/BYTES]{\"url\":\"%s\",\"headers\":%s}", url, headers);
-    if (ret < 0 || ret >= (int)sizeof(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format GET request command with headers.");
-        return false;
-    }
-
-    // Send GET request via UART
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send GET request command with headers.");
-        return false;
-    }
-
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandGetBytes, "{\"url\":\"%s\",\"headers\":%s}", url, headers);
 }
 // Function to send a POST request with headers
 /**
@@ -902,36 +2210,12 @@ bool flipper_http_post_request_with_headers(
 {
     if (!url || !headers || !payload)
     {
-        FURI_LOG_E(
-            "FlipperHTTP",
-            "Invalid arguments provided to flipper_http_post_request_with_headers.");
-        return false;
-    }
-
-    // Prepare POST request command with headers and data
-    char command[256];
-    int ret = snprintf(
-        command,
-        sizeof(command),
-        "[POST/HTTP]{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}",
-        url,
-        headers,
-        payload);
-    if (ret < 0 || ret >= (int)sizeof(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format POST request command with headers and data.");
-        return false;
-    }
-
-    // Send POST request via UART
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send POST request command with headers and data.");
+        FURI_LOG_E("FlipperHTTP", "Invalid arguments provided to flipper_http_post_request_with_headers.");
         return false;
     }
 
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandPostHttp, "{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}", url, headers, payload);
 }
 // Function to send a POST request with headers and return bytes
 /**
@@ -946,35 +2230,12 @@ bool flipper_http_post_request_bytes(const char *url, const char *headers, const
 {
     if (!url || !headers || !payload)
     {
-        FURI_LOG_E(
-            "FlipperHTTP", "Invalid arguments provided to flipper_http_post_request_bytes.");
-        return false;
-    }
-
-    // Prepare POST request command with headers and data
-    char command[256];
-    int ret = snprintf(
-        command,
-        sizeof(command),
-        "[POST/BYTES]{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}",
-        url,
-        headers,
-        payload);
-    if (ret < 0 || ret >= (int)sizeof(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format POST request command with headers and data.");
-        return false;
-    }
-
-    // Send POST request via UART
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send POST request command with headers and data.");
+        FURI_LOG_E("FlipperHTTP", "Invalid arguments provided to flipper_http_post_request_bytes.");
         return false;
     }
 
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandPostBytes, "{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}", url, headers, payload);
 }
 // Function to send a PUT request with headers
 /**
@@ -992,35 +2253,12 @@ bool flipper_http_put_request_with_headers(
 {
     if (!url || !headers || !payload)
     {
-        FURI_LOG_E(
-            "FlipperHTTP", "Invalid arguments provided to flipper_http_put_request_with_headers.");
-        return false;
-    }
-
-    // Prepare PUT request command with headers and data
-    char command[256];
-    int ret = snprintf(
-        command,
-        sizeof(command),
-        "[PUT/HTTP]{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}",
-        url,
-        headers,
-        payload);
-    if (ret < 0 || ret >= (int)sizeof(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to format PUT request command with headers and data.");
-        return false;
-    }
-
-    // Send PUT request via UART
-    if (!flipper_http_send_data(command))
-    {
-        FURI_LOG_E("FlipperHTTP", "Failed to send PUT request command with headers and data.");
+        FURI_LOG_E("FlipperHTTP", "Invalid arguments provided to flipper_http_put_request_with_headers.");
         return false;
     }
 
     // The response will be handled asynchronously via the callback
-    return true;
+    return flipper_http_send_command(FlipperHTTPCommandPutHttp, "{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}", url, headers, payload);
 }
 // Function to send a DELETE request with headers
 /**
@@ -1038,38 +2276,34 @@ bool flipper_http_delete_request_with_headers(
 {
     if (!url || !headers || !payload)
     {
-        FURI_LOG_E(
-            "FlipperHTTP",
-            "Invalid arguments provided to flipper_http_delete_request_with_headers.");
+        FURI_LOG_E("FlipperHTTP", "Invalid arguments provided to flipper_http_delete_request_with_headers.");
         return false;
     }
 
-    // Prepare DELETE request command with headers and data
-    char command[256];
-    int ret = snprintf(
-        command,
-        sizeof(command),
-        "[DELETE/HTTP]{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}",
-        url,
-        headers,
-        payload);
-    if (ret < 0 || ret >= (int)sizeof(command))
+    // The response will be handled asynchronously via the callback
+    return flipper_http_send_command(FlipperHTTPCommandDeleteHttp, "{\"url\":\"%s\",\"headers\":%s,\"payload\":%s}", url, headers, payload);
+}
+// Function to check whether a line outside of a request body ends the reply to the command in flight
+static bool flipper_http_line_ends_reply(FlipperHTTPLine kind, bool hook_done)
+{
+    FlipperHTTPLine expected = (FlipperHTTPLine)fhttp.expected_line;
+    if (expected == FlipperHTTPLinePayload)
     {
-        FURI_LOG_E(
-            "FlipperHTTP", "Failed to format DELETE request command with headers and data.");
-        return false;
+        // a payload reply is one line, unless the line hook parses it and says when it is over
+        if (kind == FlipperHTTPLinePayload)
+        {
+            return !fhttp.line_callback || hook_done;
+        }
+        return kind != FlipperHTTPLineInfo;
     }
-
-    // Send DELETE request via UART
-    if (!flipper_http_send_data(command))
+    if (expected == FlipperHTTPLineSuccess)
     {
-        FURI_LOG_E("FlipperHTTP", "Failed to send DELETE request command with headers and data.");
-        return false;
+        // "[INFO] Already connected to Wifi." (the only info line that gets here) answers a connect too
+        return kind == FlipperHTTPLineSuccess || kind == FlipperHTTPLineConnected || kind == FlipperHTTPLineInfo;
     }
-
-    // The response will be handled asynchronously via the callback
-    return true;
+    return kind == expected;
 }
+
 // Function to handle received data asynchronously
 /**
  * @brief      Callback function to handle received data asynchronously.
@@ -1086,20 +2320,28 @@ void flipper_http_rx_callback(const char *line, void *context)
         return;
     }
 
-    // Trim the received line to check if it's empty
-    char *trimmed_line = trim(line);
-    if (trimmed_line != NULL && trimmed_line[0] != '\0')
+    // Classify the line and trim it by offsets, without copying it
+    const char *text;
+    size_t text_len;
+    FlipperHTTPLine kind = flipper_http_classify_line(line, &text, &text_len);
+
+    // Hand payload lines to the hook before anything else looks at them
+    bool hook_done = false;
+    if (kind == FlipperHTTPLinePayload && fhttp.line_callback)
+    {
+        hook_done = fhttp.line_callback(text, text_len, fhttp.line_context);
+    }
+
+    // Keep the line as the last response unless it only frames a request
+    if (text_len > 0 && (kind < FlipperHTTPLineGetSuccess || kind > FlipperHTTPLineDeleteEnd))
     {
-        // if the line is not [GET/END] or [POST/END] or [PUT/END] or [DELETE/END]
-        if (strstr(trimmed_line, "[GET/END]") == NULL &&
-            strstr(trimmed_line, "[POST/END]") == NULL &&
-            strstr(trimmed_line, "[PUT/END]") == NULL &&
-            strstr(trimmed_line, "[DELETE/END]") == NULL)
+        if (text_len > RX_BUF_SIZE - 1)
         {
-            strncpy(fhttp.last_response, trimmed_line, RX_BUF_SIZE);
+            text_len = RX_BUF_SIZE - 1;
         }
+        memcpy(fhttp.last_response, text, text_len);
+        fhttp.last_response[text_len] = '\0';
     }
-    free(trimmed_line); // Free the allocated memory for trimmed_line
 
     if (fhttp.state != INACTIVE && fhttp.state != ISSUE)
     {
@@ -1112,301 +2354,75 @@ void flipper_http_rx_callback(const char *line, void *context)
     // custom function to FlipWiFi
     if (fhttp.save_received_data)
     {
-        if (!flipper_http_append_to_file(line, strlen(line), fhttp.just_started_get, fhttp.file_path))
+        if (!flipper_http_save_to_file(line, strlen(line), fhttp.request.start_new_file))
         {
             FURI_LOG_E(HTTP_TAG, "Failed to append data to file.");
             fhttp.state = ISSUE;
             return;
         }
-        if (fhttp.just_started_get)
-        {
-            fhttp.just_started_get = false;
-        }
-    }
-
-    // Check if we've started receiving data from a GET request
-    if (fhttp.started_receiving_get)
-    {
-        // Restart the timeout timer each time new data is received
-        furi_timer_restart(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-
-        if (strstr(line, "[GET/END]") != NULL)
-        {
-            FURI_LOG_I(HTTP_TAG, "GET request completed.");
-            // Stop the timer since we've completed the GET request
-            furi_timer_stop(fhttp.get_timeout_timer);
-            fhttp.started_receiving_get = false;
-            fhttp.just_started_get = false;
-            fhttp.state = IDLE;
-            fhttp.save_bytes = false;
-            fhttp.save_received_data = false;
-
-            if (fhttp.is_bytes_request)
-            {
-                // Search for the binary marker `[GET/END]` in the file buffer
-                const char marker[] = "[GET/END]";
-                const size_t marker_len = sizeof(marker) - 1; // Exclude null terminator
-
-                for (size_t i = 0; i <= file_buffer_len - marker_len; i++)
-                {
-                    // Check if the marker is found
-                    if (memcmp(&file_buffer[i], marker, marker_len) == 0)
-                    {
-                        // Remove the marker by shifting the remaining data left
-                        size_t remaining_len = file_buffer_len - (i + marker_len);
-                        memmove(&file_buffer[i], &file_buffer[i + marker_len], remaining_len);
-                        file_buffer_len -= marker_len;
-                        break;
-                    }
-                }
-
-                // If there is data left in the buffer, append it to the file
-                if (file_buffer_len > 0)
-                {
-                    if (!flipper_http_append_to_file(file_buffer, file_buffer_len, false, fhttp.file_path))
-                    {
-                        FURI_LOG_E(HTTP_TAG, "Failed to append data to file.");
-                    }
-                    file_buffer_len = 0;
-                }
-            }
-
-            fhttp.is_bytes_request = false;
-            return;
-        }
-
-        // Append the new line to the existing data
-        if (fhttp.save_received_data &&
-            !flipper_http_append_to_file(
-                line, strlen(line), !fhttp.just_started_get, fhttp.file_path))
-        {
-            FURI_LOG_E(HTTP_TAG, "Failed to append data to file.");
-            fhttp.started_receiving_get = false;
-            fhttp.just_started_get = false;
-            fhttp.state = IDLE;
-            return;
-        }
-
-        if (!fhttp.just_started_get)
-        {
-            fhttp.just_started_get = true;
-        }
-        return;
-    }
-
-    // Check if we've started receiving data from a POST request
-    else if (fhttp.started_receiving_post)
-    {
-        // Restart the timeout timer each time new data is received
-        furi_timer_restart(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-
-        if (strstr(line, "[POST/END]") != NULL)
-        {
-            FURI_LOG_I(HTTP_TAG, "POST request completed.");
-            // Stop the timer since we've completed the POST request
-            furi_timer_stop(fhttp.get_timeout_timer);
-            fhttp.started_receiving_post = false;
-            fhttp.just_started_post = false;
-            fhttp.state = IDLE;
-            fhttp.save_bytes = false;
-            fhttp.save_received_data = false;
-
-            if (fhttp.is_bytes_request)
-            {
-                // Search for the binary marker `[POST/END]` in the file buffer
-                const char marker[] = "[POST/END]";
-                const size_t marker_len = sizeof(marker) - 1; // Exclude null terminator
-
-                for (size_t i = 0; i <= file_buffer_len - marker_len; i++)
-                {
-                    // Check if the marker is found
-                    if (memcmp(&file_buffer[i], marker, marker_len) == 0)
-                    {
-                        // Remove the marker by shifting the remaining data left
-                        size_t remaining_len = file_buffer_len - (i + marker_len);
-                        memmove(&file_buffer[i], &file_buffer[i + marker_len], remaining_len);
-                        file_buffer_len -= marker_len;
-                        break;
-                    }
-                }
-
-                // If there is data left in the buffer, append it to the file
-                if (file_buffer_len > 0)
-                {
-                    if (!flipper_http_append_to_file(file_buffer, file_buffer_len, false, fhttp.file_path))
-                    {
-                        FURI_LOG_E(HTTP_TAG, "Failed to append data to file.");
-                    }
-                    file_buffer_len = 0;
-                }
-            }
-
-            fhttp.is_bytes_request = false;
-            return;
-        }
-
-        // Append the new line to the existing data
-        if (fhttp.save_received_data &&
-            !flipper_http_append_to_file(
-                line, strlen(line), !fhttp.just_started_post, fhttp.file_path))
-        {
-            FURI_LOG_E(HTTP_TAG, "Failed to append data to file.");
-            fhttp.started_receiving_post = false;
-            fhttp.just_started_post = false;
-            fhttp.state = IDLE;
-            return;
-        }
-
-        if (!fhttp.just_started_post)
-        {
-            fhttp.just_started_post = true;
-        }
-        return;
-    }
-
-    // Check if we've started receiving data from a PUT request
-    else if (fhttp.started_receiving_put)
-    {
-        // Restart the timeout timer each time new data is received
-        furi_timer_restart(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-
-        if (strstr(line, "[PUT/END]") != NULL)
-        {
-            FURI_LOG_I(HTTP_TAG, "PUT request completed.");
-            // Stop the timer since we've completed the PUT request
-            furi_timer_stop(fhttp.get_timeout_timer);
-            fhttp.started_receiving_put = false;
-            fhttp.just_started_put = false;
-            fhttp.state = IDLE;
-            fhttp.save_bytes = false;
-            fhttp.is_bytes_request = false;
-            fhttp.save_received_data = false;
-            return;
-        }
-
-        // Append the new line to the existing data
-        if (fhttp.save_received_data &&
-            !flipper_http_append_to_file(
-                line, strlen(line), !fhttp.just_started_put, fhttp.file_path))
-        {
-            FURI_LOG_E(HTTP_TAG, "Failed to append data to file.");
-            fhttp.started_receiving_put = false;
-            fhttp.just_started_put = false;
-            fhttp.state = IDLE;
-            return;
-        }
-
-        if (!fhttp.just_started_put)
-        {
-            fhttp.just_started_put = true;
-        }
-        return;
+        fhttp.request.start_new_file = false;
     }
 
-    // Check if we've started receiving data from a DELETE request
-    else if (fhttp.started_receiving_delete)
+    // Check if we're receiving the body of a GET/POST/PUT/DELETE request
+    if (fhttp.request.receiving != FlipperHTTPVerbNone)
     {
-        // Restart the timeout timer each time new data is received
-        furi_timer_restart(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-
-        if (strstr(line, "[DELETE/END]") != NULL)
-        {
-            FURI_LOG_I(HTTP_TAG, "DELETE request completed.");
-            // Stop the timer since we've completed the DELETE request
-            furi_timer_stop(fhttp.get_timeout_timer);
-            fhttp.started_receiving_delete = false;
-            fhttp.just_started_delete = false;
-            fhttp.state = IDLE;
-            fhttp.save_bytes = false;
-            fhttp.is_bytes_request = false;
-            fhttp.save_received_data = false;
-            return;
-        }
-
-        // Append the new line to the existing data
-        if (fhttp.save_received_data &&
-            !flipper_http_append_to_file(
-                line, strlen(line), !fhttp.just_started_delete, fhttp.file_path))
-        {
-            FURI_LOG_E(HTTP_TAG, "Failed to append data to file.");
-            fhttp.started_receiving_delete = false;
-            fhttp.just_started_delete = false;
-            fhttp.state = IDLE;
-            return;
-        }
+        FlipperHTTPVerb verb = fhttp.request.receiving;
 
-        if (!fhttp.just_started_delete)
+        if (kind == flipper_http_end_line(verb))
         {
-            fhttp.just_started_delete = true;
+            flipper_http_finish_response(verb);
         }
         return;
     }
 
     // Handle different types of responses
-    if (strstr(line, "[SUCCESS]") != NULL || strstr(line, "[CONNECTED]") != NULL)
+    if (kind == FlipperHTTPLineSuccess || kind == FlipperHTTPLineConnected)
     {
         FURI_LOG_I(HTTP_TAG, "Operation succeeded.");
     }
-    else if (strstr(line, "[INFO]") != NULL)
+    else if (kind == FlipperHTTPLineInfo)
     {
         FURI_LOG_I(HTTP_TAG, "Received info: %s", line);
 
-        if (fhttp.state == INACTIVE && strstr(line, "[INFO] Already connected to Wifi.") != NULL)
+        static const char already_connected[] = "[INFO] Already connected to Wifi.";
+        if (strncmp(text, already_connected, sizeof(already_connected) - 1) != 0)
+        {
+            // progress while the board works on the command: restart the idle timer and keep waiting
+            fhttp.last_activity_tick = furi_get_tick();
+            return;
+        }
+        if (fhttp.state == INACTIVE)
         {
             fhttp.state = IDLE;
         }
     }
-    else if (strstr(line, "[GET/SUCCESS]") != NULL)
-    {
-        FURI_LOG_I(HTTP_TAG, "GET request succeeded.");
-        fhttp.started_receiving_get = true;
-        furi_timer_start(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-        fhttp.state = RECEIVING;
-        // for GET request, save data only if it's a bytes request
-        fhttp.save_bytes = fhttp.is_bytes_request;
-        fhttp.just_started_bytes = true;
-        file_buffer_len = 0;
-        return;
-    }
-    else if (strstr(line, "[POST/SUCCESS]") != NULL)
+    else if (kind >= FlipperHTTPLineGetSuccess && kind <= FlipperHTTPLineDeleteSuccess)
     {
-        FURI_LOG_I(HTTP_TAG, "POST request succeeded.");
-        fhttp.started_receiving_post = true;
-        furi_timer_start(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
+        FlipperHTTPVerb verb = (FlipperHTTPVerb)(FlipperHTTPVerbGet + (kind - FlipperHTTPLineGetSuccess));
+        FURI_LOG_I(HTTP_TAG, "%s request succeeded.", flipper_http_verb_names[verb]);
+        fhttp.request.receiving = verb;
+        fhttp.expected_line = flipper_http_end_line(verb);
+        fhttp.timeout.total_ms = 0; // from here on only the idle gap limits the body
+        flipper_http_arm_timeout();
         fhttp.state = RECEIVING;
-        // for POST request, save data only if it's a bytes request
+        // save data only if it's a bytes request (GET and POST)
         fhttp.save_bytes = fhttp.is_bytes_request;
         fhttp.just_started_bytes = true;
-        file_buffer_len = 0;
-        return;
-    }
-    else if (strstr(line, "[PUT/SUCCESS]") != NULL)
-    {
-        FURI_LOG_I(HTTP_TAG, "PUT request succeeded.");
-        fhttp.started_receiving_put = true;
-        furi_timer_start(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-        fhttp.state = RECEIVING;
-        return;
-    }
-    else if (strstr(line, "[DELETE/SUCCESS]") != NULL)
-    {
-        FURI_LOG_I(HTTP_TAG, "DELETE request succeeded.");
-        fhttp.started_receiving_delete = true;
-        furi_timer_start(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-        fhttp.state = RECEIVING;
+        fhttp.bytes_match = 0;
         return;
     }
-    else if (strstr(line, "[DISCONNECTED]") != NULL)
+    else if (kind == FlipperHTTPLineDisconnected)
     {
         FURI_LOG_I(HTTP_TAG, "WiFi disconnected successfully.");
     }
-    else if (strstr(line, "[ERROR]") != NULL)
+    else if (kind == FlipperHTTPLineError)
     {
         FURI_LOG_E(HTTP_TAG, "Received error: %s", line);
         fhttp.state = ISSUE;
+        flipper_http_complete_request(false);
         return;
     }
-    else if (strstr(line, "[PONG]") != NULL)
+    else if (kind == FlipperHTTPLinePong)
     {
         FURI_LOG_I(HTTP_TAG, "Received PONG response: Wifi Dev Board is still alive.");
 
@@ -1414,15 +2430,16 @@ void flipper_http_rx_callback(const char *line, void *context)
         if (fhttp.state == INACTIVE)
         {
             fhttp.state = IDLE;
+            flipper_http_complete_request(true);
             return;
         }
     }
 
-    if (fhttp.state == INACTIVE && strstr(line, "[PONG]") != NULL)
+    if (fhttp.state == INACTIVE && kind == FlipperHTTPLinePong)
     {
         fhttp.state = IDLE;
     }
-    else if (fhttp.state == INACTIVE && strstr(line, "[PONG]") == NULL)
+    else if (fhttp.state == INACTIVE && kind != FlipperHTTPLinePong)
     {
         fhttp.state = INACTIVE;
     }
@@ -1430,43 +2447,12 @@ void flipper_http_rx_callback(const char *line, void *context)
     {
         fhttp.state = IDLE;
     }
-}
 
-// Function to trim leading and trailing spaces and newlines from a constant string
-char *trim(const char *str)
-{
-    const char *end;
-    char *trimmed_str;
-    size_t len;
-
-    // Trim leading space
-    while (isspace((unsigned char)*str))
-        str++;
-
-    // All spaces?
-    if (*str == 0)
-        return strdup(""); // Return an empty string if all spaces
-
-    // Trim trailing space
-    end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end))
-        end--;
-
-    // Set length for the trimmed string
-    len = end - str + 1;
-
-    // Allocate space for the trimmed string and null terminator
-    trimmed_str = (char *)malloc(len + 1);
-    if (trimmed_str == NULL)
+    // Only the reply the command waits for ends it (errors were handled above)
+    if (flipper_http_line_ends_reply(kind, hook_done))
     {
-        return NULL; // Handle memory allocation failure
+        flipper_http_complete_request(true);
     }
-
-    // Copy the trimmed part of the string into trimmed_str
-    strncpy(trimmed_str, str, len);
-    trimmed_str[len] = '\0'; // Null terminate the string
-
-    return trimmed_str;
 }
 
 /**
@@ -1477,22 +2463,27 @@ char *trim(const char *str)
  */
 bool flipper_http_process_response_async(bool (*http_request)(void), bool (*parse_json)(void))
 {
-    if (http_request()) // start the async request
-    {
-        furi_timer_start(fhttp.get_timeout_timer, TIMEOUT_DURATION_TICKS);
-        fhttp.state = RECEIVING;
-    }
-    else
+    // the send sets the state and arms the watchdog before the line goes out, so a reply
+    // completing before it returns is not overwritten here
+    if (!http_request()) // start the async request
     {
         FURI_LOG_E(HTTP_TAG, "Failed to send request");
         return false;
     }
-    while (fhttp.state == RECEIVING && furi_timer_is_running(fhttp.get_timeout_timer) > 0)
+    // Wait for the END marker, the reply or the request timeout
+    bool completed = flipper_http_wait_response(RESPONSE_TIMEOUT_MS) && fhttp.state != ISSUE;
+    flipper_http_disarm_timeout();
+
+    // make sure the saved response is on the SD card before parsing it
+    fhttp.save_received_data = false;
+    flipper_http_file_close();
+
+    if (!completed)
     {
-        // Wait for the request to be received
-        furi_delay_ms(100);
+        FURI_LOG_E(HTTP_TAG, "The request did not complete, nothing to parse");
+        return false;
     }
-    furi_timer_stop(fhttp.get_timeout_timer);
+
     if (!parse_json()) // parse the JSON before switching to the view (synchonous)
     {
         FURI_LOG_E(HTTP_TAG, "Failed to parse the JSON...");
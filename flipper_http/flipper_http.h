@@ -11,18 +11,35 @@
 #include <furi_hal_gpio.h>
 #include <furi_hal_serial.h>
 #include <storage/storage.h>
+#include <jsmn/jsmn_furi.h>
 
 // STORAGE_EXT_PATH_PREFIX is defined in the Furi SDK as /ext
 
 #define HTTP_TAG "FlipWiFi"               // change this to your app name
 #define http_tag "flip_wifi"              // change this to your app id
 #define UART_CH (FuriHalSerialIdUsart)    // UART channel
-#define TIMEOUT_DURATION_TICKS (5 * 1000) // 5 seconds
-#define BAUDRATE (115200)                 // UART baudrate
+#define TIMEOUT_DURATION_TICKS (5 * 1000) // 5 seconds (budgets of commands without their own class)
+#define TIMEOUT_TICK_MS 100               // how often the request watchdog checks the budgets
+#define TIMEOUT_MIN_MS 500                // an adapted budget never drops below this
+#define TIMEOUT_MARGIN_MS 1000            // slack added to three times the observed response time
+#define RESPONSE_TIMEOUT_MS (30 * 1000)   // longest wait for a whole response
+#define FLIPPER_HTTP_COMMAND_COUNT 21     // commands the library knows, plus one for raw commands
+#define BAUDRATE (115200)                 // UART baudrate (every session starts and ends here)
+#define BAUDRATE_HIGH (921600)            // UART baudrate negotiated after PONG (with FLIPPER_HTTP_BAUDRATE_NEGOTIATION)
+#define BAUDRATE_CONFIRM_MS 1000          // how long to wait for the confirm PONG at a new rate
+#define FLIPPER_HTTP_BAUDRATE_NEGOTIATION false // switch to BAUDRATE_HIGH after PONG (needs firmware that knows [UART/BAUDRATE])
 #define RX_BUF_SIZE 2048                  // UART RX buffer size
 #define RX_LINE_BUFFER_SIZE 4096          // UART RX line buffer size (increase for large responses)
-#define MAX_FILE_SHOW 4096                // Maximum data from file to show
-#define FILE_BUFFER_SIZE 512              // File buffer size
+#define FILE_READ_CHUNK_SIZE 512          // Block size used when reading files back
+#define FILE_LOAD_HEAP_RESERVE 8192       // Free heap left over when loading a whole file into memory
+#define FILE_WRITE_BUFFER_SIZE 2048       // Write-behind buffer size for the open response file
+#define UART_RX_DMA true                  // batch received bytes via DMA (false for one interrupt per byte)
+#define RX_DMA_CHUNK_SIZE 64              // bytes copied out of the DMA buffer per read
+#define RX_WORKER_CHUNK_SIZE 256          // bytes drained from the stream buffer per read
+#define RX_THREAD_STACK_SIZE 3072         // worker stack: line hooks, completion callbacks, storage and the command buffer
+#define REQUEST_QUEUE_SIZE 4              // commands that can wait behind the one in flight
+#define COMMAND_MAX_LENGTH 256            // longest command accepted by flipper_http_send_data
+#define FLIPPER_HTTP_REPLAY false         // build the UART capture and replay tools (for measuring the RX path)
 
 // Forward declaration for callback
 typedef void (*FlipperHTTP_Callback)(const char *line, void *context);
@@ -42,8 +59,80 @@ typedef enum
 {
     WorkerEvtStop = (1 << 0),
     WorkerEvtRxDone = (1 << 1),
+    WorkerEvtFileClose = (1 << 2),
+    WorkerEvtQueueNext = (1 << 3),
+    WorkerEvtTimeout = (1 << 4),
+    WorkerEvtFileCloseSync = (1 << 5), // close the response file, then release file_closed
 } WorkerEvtFlags;
 
+// Verb of the HTTP request whose body is being received
+typedef enum
+{
+    FlipperHTTPVerbNone,
+    FlipperHTTPVerbGet,
+    FlipperHTTPVerbPost,
+    FlipperHTTPVerbPut,
+    FlipperHTTPVerbDelete,
+} FlipperHTTPVerb;
+
+// Callback handed each payload line (trimmed, not NUL terminated at length); returns true once the line ended the reply
+typedef bool (*FlipperHTTP_Line)(const char *line, size_t length, void *context);
+
+// Completion callback for a queued command (called from the worker thread)
+typedef void (*FlipperHTTP_Complete)(uint32_t request_id, bool success, const char *response, void *context);
+
+// Record of the request in flight
+typedef struct
+{
+    uint32_t id;                      // Id from flipper_http_enqueue (0 for a direct send)
+    FlipperHTTPVerb receiving;        // Verb whose body is being received (None until its SUCCESS line)
+    bool start_new_file;              // The next saved line starts a new file
+    FlipperHTTP_Complete on_complete; // Called when the response completes
+    void *on_complete_context;        // Context for on_complete
+} FlipperHTTPRequest;
+
+// Kind of command, for its timeout budget
+typedef enum
+{
+    FlipperHTTPTimeoutDefault, // anything not listed below
+    FlipperHTTPTimeoutPing,    // [PING]
+    FlipperHTTPTimeoutScan,    // [WIFI/SCAN]
+    FlipperHTTPTimeoutConnect, // [WIFI/CONNECT]
+    FlipperHTTPTimeoutHttp,    // GET/POST/PUT/DELETE and their BYTES variants
+    FlipperHTTPTimeoutClassCount,
+} FlipperHTTPTimeoutClass;
+
+// Time budgets of a request, in milliseconds
+typedef struct
+{
+    uint32_t connect_ms; // from sending the command to the first byte back
+    uint32_t idle_ms;    // longest gap between received bytes after that
+    uint32_t total_ms;   // from sending the command to the end of the response (0: no limit while bytes keep coming)
+} FlipperHTTPTimeout;
+
+// Counters for one request, or added up over the session
+typedef struct
+{
+    uint32_t requests;          // requests completed
+    uint32_t timeouts;          // requests that timed out
+    uint32_t first_byte_ms;     // time from sending the command to the first byte back
+    uint32_t transfer_ms;       // time from sending the command to its completion
+    uint32_t bytes_received;    // bytes read from the UART
+    uint32_t lines_received;    // lines handed to the line callback
+    uint32_t dropped_bytes;     // bytes lost because the stream buffer was full
+    uint32_t sd_write_ms;       // time spent writing the response file
+    uint32_t stream_high_water; // most bytes waiting in the stream buffer (the maximum, in the totals)
+} FlipperHTTPStats;
+
+// Command waiting in the request queue
+typedef struct
+{
+    uint32_t id;
+    char command[COMMAND_MAX_LENGTH];
+    FlipperHTTP_Complete on_complete;
+    void *on_complete_context;
+} FlipperHTTPQueuedCommand;
+
 // FlipperHTTP Structure
 typedef struct
 {
@@ -53,26 +142,34 @@ typedef struct
     FuriThreadId rx_thread_id;              // Worker thread ID
     FlipperHTTP_Callback handle_rx_line_cb; // Callback for received lines
     void *callback_context;                 // Context for the callback
+    FlipperHTTP_Callback session_callback;  // Callback kept to reconnect the session
+    void *session_context;                  // Context kept to reconnect the session
     SerialState state;                      // State of the UART
+    uint32_t baudrate;                      // Baudrate the UART is running at
 
     // variable to store the last received data from the UART
     char *last_response;
     char file_path[256]; // Path to save the received data
 
     // Timer-related members
-    FuriTimer *get_timeout_timer; // Timer for HTTP request timeout
-
-    bool started_receiving_get; // Indicates if a GET request has started
-    bool just_started_get;      // Indicates if GET data reception has just started
+    FuriTimer *get_timeout_timer; // Periodic watchdog checking the budgets of the request in flight
 
-    bool started_receiving_post; // Indicates if a POST request has started
-    bool just_started_post;      // Indicates if POST data reception has just started
+    // Timeout budgets of the request in flight, checked by the watchdog
+    uint8_t command;                       // Command in flight (index of the command table)
+    uint8_t expected_line;                 // Marker the command in flight answers with next, matched first
+    FlipperHTTPTimeout timeout;            // Its budgets, adapted when it was sent
+    volatile uint32_t last_activity_tick;  // Tick of the last received byte (0 if none yet)
+    volatile bool timeout_armed;           // The watchdog is checking the request in flight
+    volatile bool timeout_expired;         // It ran out, the worker still has to fail it
 
-    bool started_receiving_put; // Indicates if a PUT request has started
-    bool just_started_put;      // Indicates if PUT data reception has just started
+    // Average time to the first byte back of each command, its connect budget adapts to it
+    uint32_t observed_first_byte_ms[FLIPPER_HTTP_COMMAND_COUNT];
+    FuriSemaphore *response_done; // Released when a response completes (END, reply line, error or timeout)
 
-    bool started_receiving_delete; // Indicates if a DELETE request has started
-    bool just_started_delete;      // Indicates if DELETE data reception has just started
+    FlipperHTTPRequest request;         // The request in flight
+    FuriMutex *request_mutex;           // Guards the request record between threads
+    FuriMessageQueue *request_queue;    // Commands waiting for the request in flight to complete
+    uint32_t next_request_id;           // Id handed to the next queued command
 
     // Buffer to hold the raw bytes received from the UART
     uint8_t *received_bytes;
@@ -82,13 +179,35 @@ typedef struct
     bool save_received_data;   // Flag to save the received data to a file
 
     bool just_started_bytes; // Indicates if bytes data reception has just started
+    size_t bytes_match;      // Bytes of the END marker matched so far in a bytes response
+
+    // Response file kept open for the duration of a request, owned by the worker thread
+    Storage *file_storage;        // Storage record held while the file is open
+    File *file_handle;            // Open file handle (NULL when closed)
+    uint8_t *file_write_buffer;   // Write-behind buffer coalescing small appends
+    size_t file_write_buffer_len; // Bytes waiting in the write-behind buffer
+    FuriSemaphore *file_closed;   // Released by the worker once it closed the file for another thread
+
+    // Instrumentation, updated on the worker thread (drops are counted by the RX interrupt)
+    FlipperHTTPStats stats_request; // Request in flight
+    FlipperHTTPStats stats_last;    // Last completed request
+    FlipperHTTPStats stats_total;   // All requests since the session started
+    uint32_t request_start_tick;    // Tick the request in flight was sent at (0 if none)
+    bool first_byte_seen;           // A byte arrived since the request was sent
+    volatile uint32_t rx_dropped;   // Bytes dropped by the RX interrupt since the session started
+    uint32_t rx_dropped_at_start;   // rx_dropped when the request in flight was sent
+
+#if FLIPPER_HTTP_REPLAY
+    File *capture_file; // Optional file every received byte is copied to
+#endif
+
+    FlipperHTTP_Line line_callback; // Optional hook fed with each payload line as it arrives
+    void *line_context;             // Context for the line hook
 } FlipperHTTP;
 
 extern FlipperHTTP fhttp;
 // Global static array for the line buffer
 extern char rx_line_buffer[RX_LINE_BUFFER_SIZE];
-extern uint8_t file_buffer[FILE_BUFFER_SIZE];
-extern size_t file_buffer_len;
 
 // fhttp.last_response holds the last received data from the UART
 
@@ -100,8 +219,137 @@ bool flipper_http_append_to_file(
     bool start_new_file,
     char *file_path);
 
+// Callback for flipper_http_read_file_chunks: return false to stop reading
+typedef bool (*FlipperHTTP_Chunk)(const uint8_t *data, size_t length, size_t offset, void *context);
+
+// Function to read a file in fixed-size blocks
+/**
+ * @brief      Read a file block by block, handing each block to a callback.
+ * @return     true if the whole file was read (or the callback stopped early), false on error.
+ * @param      file_path   The path of the file to read.
+ * @param      chunk_size  The block size in bytes (FILE_READ_CHUNK_SIZE if 0).
+ * @param      callback    Called with each block and its offset; return false to stop.
+ * @param      context     The context passed to the callback.
+ * @note       Memory use is one block however large the file is. Each block is followed by a
+ *             NUL byte (not counted in its length) so text can be appended directly.
+ */
+bool flipper_http_read_file_chunks(const char *file_path, size_t chunk_size, FlipperHTTP_Chunk callback, void *context);
+
+// Function to read part of a file
+/**
+ * @brief      Read up to length bytes of a file starting at offset.
+ * @return     The number of bytes read (0 past the end, or if the file cannot be read).
+ * @param      file_path  The path of the file to read.
+ * @param      offset     The position of the first byte to read.
+ * @param      buffer     The buffer to read into.
+ * @param      length     The size of the buffer.
+ */
+size_t flipper_http_read_file_window(const char *file_path, size_t offset, void *buffer, size_t length);
+
+// Function to load a whole file into a string (NULL if it is missing or does not fit in memory)
 FuriString *flipper_http_load_from_file(char *file_path);
 
+// Function to open the response file once for a whole request
+/**
+ * @brief      Open a file to stream the response of a request into.
+ * @return     true if the file was opened successfully, false otherwise.
+ * @param      file_path       The path of the file to write.
+ * @param      start_new_file  true to truncate the file, false to append to it.
+ * @note       Data written with flipper_http_file_write is buffered until flushed or closed.
+ */
+bool flipper_http_file_open(const char *file_path, bool start_new_file);
+
+// Function to append data to the open response file
+/**
+ * @brief      Append data to the file opened with flipper_http_file_open.
+ * @return     true if the data was buffered or written successfully, false otherwise.
+ * @param      data       The data to append.
+ * @param      data_size  The size of the data.
+ */
+bool flipper_http_file_write(const void *data, size_t data_size);
+
+// Function to write the buffered data to the open response file
+/**
+ * @brief      Write any buffered data to the open response file.
+ * @return     true if the buffer was written successfully, false otherwise.
+ */
+bool flipper_http_file_flush();
+
+// Function to flush and close the open response file
+/**
+ * @brief      Flush and close the file opened with flipper_http_file_open.
+ * @return     void
+ * @note       Safe to call when no file is open. Called from another thread while the worker runs,
+ *             the worker closes the file and this waits until it is done.
+ */
+void flipper_http_file_close();
+
+// Function to receive payload lines as they arrive
+/**
+ * @brief      Set a hook that is handed every payload line (not framing, status or error lines).
+ * @return     void
+ * @param      callback  The hook (NULL to detach); runs on the UART worker thread.
+ * @param      context   The context passed to the hook.
+ * @note       Lets a reply be parsed while it arrives instead of from a saved file. While a hook is set,
+ *             a command whose reply is plain payload completes when the hook returns true.
+ */
+void flipper_http_set_line_callback(FlipperHTTP_Line callback, void *context);
+
+// Function to read the request counters
+/**
+ * @brief      Copy the counters of the last completed request and the session totals.
+ * @return     void
+ * @param      last   Set to the counters of the last completed request (may be NULL).
+ * @param      total  Set to the counters added up over the session (may be NULL).
+ * @note       Times are in milliseconds; the totals add them up, divide by requests for averages.
+ */
+void flipper_http_get_stats(FlipperHTTPStats *last, FlipperHTTPStats *total);
+
+// Function to clear the request counters
+/**
+ * @brief      Reset the counters of the last request and the session totals.
+ * @return     void
+ */
+void flipper_http_reset_stats();
+
+#if FLIPPER_HTTP_REPLAY
+// Result of replaying a UART transcript
+typedef struct
+{
+    uint32_t elapsed_ms;       // time from the first byte to the worker going idle
+    uint32_t bytes;            // bytes replayed
+    uint32_t bytes_per_second; // replay throughput
+    uint32_t dropped_bytes;    // bytes that did not fit in the stream buffer (paced replays only)
+    size_t heap_before;        // free heap when the replay started
+    size_t heap_after;         // free heap when it finished
+    size_t heap_min;           // least free heap seen while it ran
+    size_t worker_heap_peak;   // most heap the worker held from its allocations during the replay
+    size_t worker_heap_after;  // heap those allocations still held when it finished
+    uint32_t stack_free;       // worker stack never touched so far
+} FlipperHTTPReplayReport;
+
+// Function to capture the received UART bytes to a file
+/**
+ * @brief      Copy every byte the worker receives to a file, for replaying later.
+ * @return     true if the capture file was opened (or the capture stopped), false otherwise.
+ * @param      file_path  The file to write (NULL to stop capturing).
+ */
+bool flipper_http_capture(const char *file_path);
+
+// Function to replay a captured UART transcript
+/**
+ * @brief      Feed a transcript through the worker as if the board had sent it.
+ * @return     true if the transcript was replayed, false otherwise.
+ * @param      file_path         The transcript (ex. written by flipper_http_capture).
+ * @param      bytes_per_second  The rate to feed it at (0 for as fast as the worker takes it).
+ * @param      bytes_path        Where to save the body of a bytes response (NULL for text responses).
+ * @param      report            Set to the timings, heap use and worker allocations of the replay.
+ * @note       Runs on the calling thread and returns once the worker has drained the transcript.
+ *             The request counters (flipper_http_get_stats) cover the replayed responses.
+ */
+bool flipper_http_replay(const char *file_path, uint32_t bytes_per_second, const char *bytes_path, FlipperHTTPReplayReport *report);
+#endif
+
 // UART worker thread
 /**
  * @brief      Worker thread to handle UART data asynchronously.
@@ -114,10 +362,10 @@ int32_t flipper_http_worker(void *context);
 
 // Timer callback function
 /**
- * @brief      Callback function for the GET timeout timer.
- * @return     0
+ * @brief      Watchdog tick checking the timeout budgets of the request in flight.
+ * @return     void
  * @param      context   The context to pass to the callback.
- * @note       This function will be called when the GET request times out.
+ * @note       Fails the request once its connect, idle or total budget is used up.
  */
 void get_timeout_timer_callback(void *context);
 
@@ -135,6 +383,22 @@ void _flipper_http_rx_callback(
     FuriHalSerialRxEvent event,
     void *context);
 
+// UART DMA RX Handler Callback (Interrupt Context)
+/**
+ * @brief      A private callback function to handle batched DMA data asynchronously.
+ * @return     void
+ * @param      handle    The UART handle.
+ * @param      event     The event type (data on half/full transfer, idle on idle line).
+ * @param      data_len  The number of bytes waiting in the DMA buffer.
+ * @param      context   The context to pass to the callback.
+ * @note       The worker is signaled once per chunk instead of once per byte.
+ */
+void _flipper_http_rx_dma_callback(
+    FuriHalSerialHandle *handle,
+    FuriHalSerialRxEvent event,
+    size_t data_len,
+    void *context);
+
 // UART initialization function
 /**
  * @brief      Initialize UART.
@@ -153,15 +417,63 @@ bool flipper_http_init(FlipperHTTP_Callback callback, void *context);
  */
 void flipper_http_deinit();
 
+// Function to start the app-lifetime session
+/**
+ * @brief      Start a session that keeps the UART open across screens.
+ * @return     true if the UART is open, false otherwise.
+ * @param      callback  The callback function to handle received data (ex. flipper_http_rx_callback).
+ * @param      context   The context to pass to the callback.
+ * @note       The callback and context are kept so flipper_http_session_ensure can reconnect.
+ */
+bool flipper_http_session_start(FlipperHTTP_Callback callback, void *context);
+
+// Function to make sure the session's UART is open
+/**
+ * @brief      Reuse the open session, reconnecting only if the port was lost.
+ * @return     true if the UART is open, false otherwise.
+ * @note       Call before each action instead of flipper_http_init.
+ */
+bool flipper_http_session_ensure();
+
+// Function to end the app-lifetime session
+/**
+ * @brief      Close the session's UART and forget its callback.
+ * @return     void
+ */
+void flipper_http_session_end();
+
 // Function to send data over UART with newline termination
 /**
  * @brief      Send data over UART with newline termination.
  * @return     true if the data was sent successfully, false otherwise.
  * @param      data  The data to send over UART.
  * @note       The data will be sent over UART with a newline character appended.
+ *             It is refused while a queued request is in flight, use flipper_http_enqueue to send after it.
  */
 bool flipper_http_send_data(const char *data);
 
+// Function to queue a command behind the request in flight
+/**
+ * @brief      Queue a command to send as soon as the request in flight completes.
+ * @return     The request id passed to on_complete, or 0 if the command could not be queued.
+ * @param      command              The command to send (ex. "[WIFI/CONNECT]").
+ * @param      on_complete          Called with the result when the response completes (may be NULL).
+ * @param      on_complete_context  The context to pass to on_complete.
+ * @note       Lets callers chain commands (ex. PING, WIFI/CONNECT, IP/WIFI) without blocking between them.
+ *             on_complete runs on the worker thread, so it must not block.
+ */
+uint32_t flipper_http_enqueue(const char *command, FlipperHTTP_Complete on_complete, void *on_complete_context);
+
+// Function to wait for the response to the last command
+/**
+ * @brief      Block until the response to the last command completes or the wait times out.
+ * @return     true if the response completed, false if nothing arrived in time.
+ * @param      timeout_ms  The longest time to wait, in milliseconds.
+ * @note       A response completes on its END marker, a single-line reply, an error or the request timeout.
+ *             Check fhttp.state for ISSUE to tell a failed response from a good one.
+ */
+bool flipper_http_wait_response(uint32_t timeout_ms);
+
 // Function to send a PING request
 /**
  * @brief      Send a PING request to check if the Wifi Dev Board is connected.
@@ -172,6 +484,28 @@ bool flipper_http_send_data(const char *data);
  */
 bool flipper_http_ping();
 
+// Function to send a PING and wait for the PONG
+/**
+ * @brief      Send a PING and wait until the PONG arrives or the wait times out.
+ * @return     true if the Wifi Dev Board answered, false otherwise.
+ * @param      timeout_ms  The longest time to wait, in milliseconds.
+ */
+bool flipper_http_ping_wait(uint32_t timeout_ms);
+
+#if FLIPPER_HTTP_BAUDRATE_NEGOTIATION
+// Function to negotiate a faster UART baudrate
+/**
+ * @brief      Ask the Wifi Dev Board to switch baudrate, then confirm the link with a PING.
+ * @return     true if the link now runs at the requested baudrate, false if it stayed (or went back) at the old one.
+ * @param      baudrate  The baudrate to switch to (ex. BAUDRATE_HIGH).
+ * @note       Boards acknowledge [UART/BAUDRATE] with [SUCCESS] at the old rate and then switch.
+ *             Flashes that do not know the command reply with an error (or nothing) and keep the old rate.
+ *             If the confirm PING fails, both sides fall back to the old rate.
+ *             The board is switched back to BAUDRATE before the UART is released.
+ */
+bool flipper_http_negotiate_baudrate(uint32_t baudrate);
+#endif
+
 // Function to list available commands
 /**
  * @brief      Send a command to list available commands.
@@ -221,7 +555,7 @@ bool flipper_http_parse_json_array(const char *key, int index, const char *json_
 /**
  * @brief      Send a command to scan for WiFi networks.
  * @return     true if the request was successful, false otherwise.
- * @note       The received data will be handled asynchronously via the callback.
+ * @note       The reply is handed to the hook set with flipper_http_set_line_callback as it arrives.
  */
 bool flipper_http_scan_wifi();
 
@@ -357,8 +691,6 @@ bool flipper_http_delete_request_with_headers(
  */
 void flipper_http_rx_callback(const char *line, void *context);
 
-// Function to trim leading and trailing spaces and newlines from a constant string
-char *trim(const char *str);
 /**
  * @brief Process requests and parse JSON data asynchronously
  * @param http_request The function to send the request
@@ -9,7 +9,7 @@
 #include <jsmn/jsmn_furi.h>
 
 // Forward declarations of helper functions
-static int jsoneq_furi(const FuriString *json, jsmntok_t *tok, const FuriString *s);
+static int jsoneq_furi(const FuriString *json, const jsmntok_t *tok, const char *s);
 static int skip_token(const jsmntok_t *tokens, int start, int total);
 
 /**
@@ -411,9 +411,9 @@ FuriString *get_json_furi(const FuriString *key, const FuriString *value)
 }
 
 // Helper function to compare JSON keys
-static int jsoneq_furi(const FuriString *json, jsmntok_t *tok, const FuriString *s)
+static int jsoneq_furi(const FuriString *json, const jsmntok_t *tok, const char *s)
 {
-    size_t s_len = furi_string_size(s);
+    size_t s_len = strlen(s);
     size_t tok_len = tok->end - tok->start;
 
     if (tok->type != JSMN_STRING)
@@ -421,13 +421,8 @@ static int jsoneq_furi(const FuriString *json, jsmntok_t *tok, const FuriString
     if (s_len != tok_len)
         return -1;
 
-    FuriString *sub = furi_string_alloc_set(json);
-    furi_string_mid(sub, tok->start, tok_len);
-
-    int res = furi_string_cmp(sub, s);
-    furi_string_free(sub);
-
-    return (res == 0) ? 0 : -1;
+    // compare in place instead of copying the document
+    return memcmp(furi_string_get_cstr(json) + tok->start, s, s_len) == 0 ? 0 : -1;
 }
 
 // Skip a token and its descendants
@@ -470,267 +465,627 @@ static int skip_token(const jsmntok_t *tokens, int start, int total)
     }
 }
 
-/**
- * Parse JSON and return the value associated with a given char* key.
- */
-FuriString *get_json_value_furi(const char *key, const FuriString *json_data)
+FuriString *json_slice_materialize_furi(FuriJSONSlice slice)
 {
-    if (json_data == NULL)
-    {
-        FURI_LOG_E("JSMM.H", "JSON data is NULL");
+    if (slice.data == NULL)
         return NULL;
-    }
-    uint32_t max_tokens = json_token_count_furi(json_data);
-    if (!jsmn_memory_check(max_tokens))
-    {
-        FURI_LOG_E("JSMM.H", "Insufficient memory for JSON tokens.");
-        return NULL;
-    }
-    // Create a temporary FuriString from key
-    FuriString *key_str = furi_string_alloc();
-    furi_string_cat_str(key_str, key);
+    FuriString *value = furi_string_alloc();
+    furi_string_set_strn(value, slice.data, slice.len);
+    return value;
+}
 
-    jsmn_parser parser;
-    jsmn_init_furi(&parser);
+bool json_slice_copy_furi(FuriJSONSlice slice, char *buffer, size_t buffer_size)
+{
+    if (slice.data == NULL || buffer_size == 0)
+        return false;
+    size_t len = slice.len < buffer_size ? slice.len : buffer_size - 1;
+    memcpy(buffer, slice.data, len);
+    buffer[len] = '\0';
+    return true;
+}
 
-    jsmntok_t *tokens = (jsmntok_t *)malloc(sizeof(jsmntok_t) * max_tokens);
-    if (tokens == NULL)
+bool json_slice_equal_furi(FuriJSONSlice slice, const char *str)
+{
+    return slice.data != NULL && strlen(str) == slice.len && memcmp(slice.data, str, slice.len) == 0;
+}
+
+// Find the array for a key in the root object of a parsed document
+static int json_doc_root_array_furi(const FuriJSONDoc *doc, const char *key)
+{
+    int array = json_doc_find_key_furi(doc, 0, key);
+    if (array < 0)
     {
-        FURI_LOG_E("JSMM.H", "Failed to allocate memory for JSON tokens.");
-        furi_string_free(key_str);
-        return NULL;
+        FURI_LOG_E("JSMM.H", "Failed to get array for key");
+        return -1;
+    }
+    if (doc->tokens[array].type != JSMN_ARRAY)
+    {
+        FURI_LOG_E("JSMM.H", "Value for key is not an array.");
+        return -1;
     }
+    return array;
+}
 
-    int ret = jsmn_parse_furi(&parser, json_data, tokens, max_tokens);
-    if (ret < 0)
+/**
+ * Parse JSON and return a view of the value associated with a given char* key.
+ */
+FuriJSONSlice get_json_value_slice_furi(const char *key, const FuriString *json_data)
+{
+    FuriJSONSlice value = {NULL, 0};
+    FuriJSONDoc doc;
+    if (!json_doc_parse_furi(&doc, json_data))
     {
-        FURI_LOG_E("JSMM.H", "Failed to parse JSON: %d", ret);
-        free(tokens);
-        furi_string_free(key_str);
-        return NULL;
+        return value;
     }
 
-    if (ret < 1 || tokens[0].type != JSMN_OBJECT)
+    if (doc.count < 1 || doc.tokens[0].type != JSMN_OBJECT)
     {
         FURI_LOG_E("JSMM.H", "Root element is not an object.");
-        free(tokens);
-        furi_string_free(key_str);
-        return NULL;
+        json_doc_free_furi(&doc);
+        return value;
     }
 
-    for (int i = 1; i < ret; i++)
+    int value_token = json_doc_find_key_furi(&doc, 0, key);
+    if (value_token < 0)
     {
-        if (jsoneq_furi(json_data, &tokens[i], key_str) == 0)
-        {
-            int length = tokens[i + 1].end - tokens[i + 1].start;
-            FuriString *value = furi_string_alloc_set(json_data);
-            furi_string_mid(value, tokens[i + 1].start, length);
-            free(tokens);
-            furi_string_free(key_str);
-            return value;
-        }
+        char warning[128];
+        snprintf(warning, sizeof(warning), "Failed to find the key \"%s\" in the JSON.", key);
+        FURI_LOG_E("JSMM.H", warning);
+    }
+    else
+    {
+        value = json_doc_slice_furi(&doc, value_token);
     }
 
-    free(tokens);
-    furi_string_free(key_str);
-    char warning[128];
-    snprintf(warning, sizeof(warning), "Failed to find the key \"%s\" in the JSON.", key);
-    FURI_LOG_E("JSMM.H", warning);
-    return NULL;
+    json_doc_free_furi(&doc);
+    return value;
 }
 
 /**
- * Return the value at a given index in a JSON array for a given char* key.
+ * Parse JSON and return the value associated with a given char* key.
  */
-FuriString *get_json_array_value_furi(const char *key, uint32_t index, const FuriString *json_data)
+FuriString *get_json_value_furi(const char *key, const FuriString *json_data)
 {
-    FuriString *array_str = get_json_value_furi(key, json_data);
-    if (array_str == NULL)
+    return json_slice_materialize_furi(get_json_value_slice_furi(key, json_data));
+}
+
+/**
+ * Return a view of the value at a given index in a JSON array for a given char* key.
+ */
+FuriJSONSlice get_json_array_value_slice_furi(const char *key, uint32_t index, const FuriString *json_data)
+{
+    FuriJSONSlice value = {NULL, 0};
+    FuriJSONDoc doc;
+    if (!json_doc_parse_furi(&doc, json_data))
     {
-        FURI_LOG_E("JSMM.H", "Failed to get array for key");
-        return NULL;
+        return value;
     }
-    uint32_t max_tokens = json_token_count_furi(array_str);
-    if (!jsmn_memory_check(max_tokens))
+
+    int array = json_doc_root_array_furi(&doc, key);
+    if (array >= 0)
     {
-        FURI_LOG_E("JSMM.H", "Insufficient memory for JSON tokens.");
-        furi_string_free(array_str);
-        return NULL;
+        value = json_doc_slice_furi(&doc, json_doc_array_get_furi(&doc, array, index));
     }
-    jsmn_parser parser;
-    jsmn_init_furi(&parser);
 
-    jsmntok_t *tokens = (jsmntok_t *)malloc(sizeof(jsmntok_t) * max_tokens);
-    if (tokens == NULL)
+    json_doc_free_furi(&doc);
+    return value;
+}
+
+/**
+ * Return the value at a given index in a JSON array for a given char* key.
+ */
+FuriString *get_json_array_value_furi(const char *key, uint32_t index, const FuriString *json_data)
+{
+    return json_slice_materialize_furi(get_json_array_value_slice_furi(key, index, json_data));
+}
+
+/**
+ * Extract all object values from a JSON array associated with a given char* key.
+ */
+FuriString **get_json_array_values_furi(const char *key, const FuriString *json_data, int *num_values)
+{
+    *num_values = 0;
+    FuriJSONDoc doc;
+    if (!json_doc_parse_furi(&doc, json_data))
     {
-        FURI_LOG_E("JSMM.H", "Failed to allocate memory for JSON tokens.");
-        furi_string_free(array_str);
         return NULL;
     }
 
-    int ret = jsmn_parse_furi(&parser, array_str, tokens, max_tokens);
-    if (ret < 0)
+    int array = json_doc_root_array_furi(&doc, key);
+    if (array < 0)
     {
-        FURI_LOG_E("JSMM.H", "Failed to parse JSON array: %d", ret);
-        free(tokens);
-        furi_string_free(array_str);
+        json_doc_free_furi(&doc);
         return NULL;
     }
 
-    if (ret < 1 || tokens[0].type != JSMN_ARRAY)
+    int array_size = json_doc_size_furi(&doc, array);
+    FuriString **values = (FuriString **)malloc(array_size * sizeof(FuriString *));
+    if (values == NULL)
     {
-        FURI_LOG_E("JSMM.H", "Value for key is not an array.");
-        free(tokens);
-        furi_string_free(array_str);
+        FURI_LOG_E("JSMM.H", "Failed to allocate memory for array of values.");
+        json_doc_free_furi(&doc);
         return NULL;
     }
 
-    if (index >= (uint32_t)tokens[0].size)
+    int element = json_doc_child_furi(&doc, array);
+    for (int i = 0; i < array_size && element >= 0; i++)
     {
-        // FURI_LOG_E("JSMM.H", "Index %lu out of bounds for array with size %u.", index, tokens[0].size);
-        free(tokens);
-        furi_string_free(array_str);
-        return NULL;
+        values[i] = json_slice_materialize_furi(json_doc_slice_furi(&doc, element));
+        (*num_values)++;
+        element = json_doc_next_furi(&doc, element);
     }
 
-    int elem_token = 1;
-    for (uint32_t i = 0; i < index; i++)
+    json_doc_free_furi(&doc);
+    return values;
+}
+
+uint32_t json_token_count_furi(const FuriString *json)
+{
+    if (json == NULL)
     {
-        elem_token = skip_token(tokens, elem_token, ret);
-        if (elem_token == -1 || elem_token >= ret)
-        {
-            FURI_LOG_E("JSMM.H", "Error skipping tokens to reach element %lu.", i);
-            free(tokens);
-            furi_string_free(array_str);
-            return NULL;
-        }
+        return JSMN_ERROR_INVAL;
     }
 
-    jsmntok_t element = tokens[elem_token];
-    int length = element.end - element.start;
+    jsmn_parser parser;
+    jsmn_init_furi(&parser);
 
-    FuriString *value = furi_string_alloc_set(array_str);
-    furi_string_mid(value, element.start, length);
+    // Pass NULL for tokens and 0 for num_tokens to get the token count only
+    int ret = jsmn_parse_furi(&parser, json, NULL, 0);
+    return ret; // If ret >= 0, it represents the number of tokens needed.
+}
 
-    free(tokens);
-    furi_string_free(array_str);
+static Arena *json_arena = NULL;
+static FuriThreadId json_arena_owner = NULL; // the only thread that carves docs from the arena
 
-    return value;
+void json_set_arena_furi(Arena *arena)
+{
+    json_arena = arena;
+    json_arena_owner = arena ? furi_thread_get_current_id() : NULL;
 }
 
-/**
- * Extract all object values from a JSON array associated with a given char* key.
- */
-FuriString **get_json_array_values_furi(const char *key, const FuriString *json_data, int *num_values)
+// Get the arena for a doc parsed on the calling thread (NULL: use the heap)
+static Arena *json_doc_arena_furi(void)
 {
-    *num_values = 0;
-    // Convert key to FuriString and call get_json_value_furi
-    FuriString *array_str = get_json_value_furi(key, json_data);
-    if (array_str == NULL)
+    return json_arena && furi_thread_get_current_id() == json_arena_owner ? json_arena : NULL;
+}
+
+// Grow a document's token array, keeping the first `used` tokens
+static bool json_doc_grow_furi(FuriJSONDoc *doc, unsigned int capacity, unsigned int used)
+{
+    Arena *arena = json_doc_arena_furi();
+    if (arena && (doc->tokens == NULL || doc->arena))
     {
-        FURI_LOG_E("JSMM.H", "Failed to get array for key");
-        return NULL;
+        // the doc's tokens are the newest block in the arena, so they grow in place
+        arena_release(arena, doc->arena_mark);
+        jsmntok_t *tokens = (jsmntok_t *)arena_push(arena, capacity * sizeof(jsmntok_t));
+        if (tokens)
+        {
+            doc->tokens = tokens;
+            doc->arena = arena;
+            return true;
+        }
     }
 
-    uint32_t max_tokens = json_token_count_furi(array_str);
-    if (!jsmn_memory_check(max_tokens))
+    if (!jsmn_memory_check(capacity * sizeof(jsmntok_t)))
     {
         FURI_LOG_E("JSMM.H", "Insufficient memory for JSON tokens.");
-        furi_string_free(array_str);
-        return NULL;
+        return false;
     }
-    jsmn_parser parser;
-    jsmn_init_furi(&parser);
 
-    jsmntok_t *tokens = (jsmntok_t *)malloc(sizeof(jsmntok_t) * max_tokens);
+    jsmntok_t *tokens;
+    if (doc->arena)
+    {
+        // the arena is full, move the tokens parsed so far to the heap
+        tokens = (jsmntok_t *)malloc(capacity * sizeof(jsmntok_t));
+        if (tokens)
+            memcpy(tokens, doc->tokens, used * sizeof(jsmntok_t));
+        doc->tokens = NULL;
+        doc->arena = NULL;
+    }
+    else
+    {
+        tokens = (jsmntok_t *)realloc(doc->tokens, capacity * sizeof(jsmntok_t));
+    }
     if (tokens == NULL)
     {
         FURI_LOG_E("JSMM.H", "Failed to allocate memory for JSON tokens.");
-        furi_string_free(array_str);
-        return NULL;
+        return false;
     }
+    doc->tokens = tokens;
+    return true;
+}
 
-    int ret = jsmn_parse_furi(&parser, array_str, tokens, max_tokens);
-    if (ret < 0)
+/**
+ * Tokenize a document once into a FuriJSONDoc.
+ * The token array starts from a size estimate and grows when jsmn runs out,
+ * resuming the same parse, so the document is normally walked only once.
+ */
+bool json_doc_parse_furi(FuriJSONDoc *doc, const FuriString *json)
+{
+    doc->json = json;
+    doc->tokens = NULL;
+    doc->count = 0;
+    doc->arena = NULL;
+    doc->arena_mark = arena_mark(json_doc_arena_furi());
+    if (json == NULL)
     {
-        FURI_LOG_E("JSMM.H", "Failed to parse JSON array: %d", ret);
-        free(tokens);
-        furi_string_free(array_str);
-        return NULL;
+        FURI_LOG_E("JSMM.H", "JSON data is NULL");
+        return false;
     }
 
-    if (tokens[0].type != JSMN_ARRAY)
+    unsigned int capacity = furi_string_size(json) / 8 + 16;
+    jsmn_parser parser;
+    jsmn_init_furi(&parser);
+
+    while (true)
     {
-        FURI_LOG_E("JSMM.H", "Value for key is not an array.");
-        free(tokens);
-        furi_string_free(array_str);
-        return NULL;
+        if (!json_doc_grow_furi(doc, capacity, parser.toknext))
+        {
+            json_doc_free_furi(doc);
+            return false;
+        }
+
+        int ret = jsmn_parse_furi(&parser, json, doc->tokens, capacity);
+        if (ret == JSMN_ERROR_NOMEM)
+        {
+            capacity *= 2;
+            continue;
+        }
+        if (ret < 0)
+        {
+            FURI_LOG_E("JSMM.H", "Failed to parse JSON: %d", ret);
+            json_doc_free_furi(doc);
+            return false;
+        }
+        doc->count = ret;
+        return true;
     }
+}
 
-    int array_size = tokens[0].size;
-    FuriString **values = (FuriString **)malloc(array_size * sizeof(FuriString *));
-    if (values == NULL)
+void json_doc_free_furi(FuriJSONDoc *doc)
+{
+    if (doc->arena)
+        arena_release(doc->arena, doc->arena_mark);
+    else
+        free(doc->tokens);
+    doc->tokens = NULL;
+    doc->arena = NULL;
+    doc->count = 0;
+}
+
+int json_doc_find_key_furi(const FuriJSONDoc *doc, int object, const char *key)
+{
+    if (object < 0 || object >= doc->count || doc->tokens[object].type != JSMN_OBJECT)
+        return -1;
+
+    int pairs = doc->tokens[object].size;
+    int i = object + 1;
+    for (int p = 0; p < pairs && i + 1 < doc->count; p++)
     {
-        FURI_LOG_E("JSMM.H", "Failed to allocate memory for array of values.");
-        free(tokens);
-        furi_string_free(array_str);
-        return NULL;
+        if (jsoneq_furi(doc->json, &doc->tokens[i], key) == 0)
+            return i + 1;
+        i = skip_token(doc->tokens, i + 1, doc->count); // skip the value
+        if (i == -1)
+            return -1;
     }
+    return -1;
+}
 
-    int actual_num_values = 0;
-    int current_token = 1;
-    for (int i = 0; i < array_size; i++)
-    {
-        if (current_token >= ret)
-        {
-            FURI_LOG_E("JSMM.H", "Unexpected end of tokens while traversing array.");
-            break;
-        }
+int json_doc_array_get_furi(const FuriJSONDoc *doc, int array, uint32_t index)
+{
+    if (array < 0 || array >= doc->count || doc->tokens[array].type != JSMN_ARRAY)
+        return -1;
+    if (index >= (uint32_t)doc->tokens[array].size)
+        return -1;
 
-        jsmntok_t element = tokens[current_token];
+    int element = array + 1;
+    for (uint32_t i = 0; i < index && element >= 0; i++)
+        element = json_doc_next_furi(doc, element);
+    return element;
+}
 
-        int length = element.end - element.start;
-        FuriString *value = furi_string_alloc_set(array_str);
-        furi_string_mid(value, element.start, length);
+int json_doc_child_furi(const FuriJSONDoc *doc, int container)
+{
+    if (container < 0 || container + 1 >= doc->count || doc->tokens[container].size == 0)
+        return -1;
+    if (doc->tokens[container].type != JSMN_OBJECT && doc->tokens[container].type != JSMN_ARRAY)
+        return -1;
+    return container + 1;
+}
 
-        values[actual_num_values] = value;
-        actual_num_values++;
+int json_doc_next_furi(const FuriJSONDoc *doc, int token)
+{
+    int next = skip_token(doc->tokens, token, doc->count);
+    return (next < 0 || next >= doc->count) ? -1 : next;
+}
 
-        // Skip this element and its descendants
-        current_token = skip_token(tokens, current_token, ret);
-        if (current_token == -1)
+int json_doc_size_furi(const FuriJSONDoc *doc, int token)
+{
+    if (token < 0 || token >= doc->count)
+        return 0;
+    return doc->tokens[token].size;
+}
+
+bool json_doc_range_furi(const FuriJSONDoc *doc, int token, size_t *start, size_t *len)
+{
+    if (token < 0 || token >= doc->count)
+        return false;
+    *start = doc->tokens[token].start;
+    *len = doc->tokens[token].end - doc->tokens[token].start;
+    return true;
+}
+
+FuriJSONSlice json_doc_slice_furi(const FuriJSONDoc *doc, int token)
+{
+    FuriJSONSlice slice = {NULL, 0};
+    size_t start, len;
+    if (json_doc_range_furi(doc, token, &start, &len))
+    {
+        slice.data = furi_string_get_cstr(doc->json) + start;
+        slice.len = len;
+    }
+    return slice;
+}
+
+bool json_doc_copy_furi(const FuriJSONDoc *doc, int token, char *buffer, size_t buffer_size)
+{
+    return json_slice_copy_furi(json_doc_slice_furi(doc, token), buffer, buffer_size);
+}
+
+// Check a value path against a watched path ("[*]" matches any array index)
+static bool jsmn_stream_path_matches(const char *pattern, const char *path, size_t path_len)
+{
+    size_t i = 0;
+    while (*pattern)
+    {
+        if (pattern[0] == '[' && pattern[1] == '*' && pattern[2] == ']')
         {
-            FURI_LOG_E("JSMM.H", "Error skipping tokens after element %d.", i);
-            break;
+            if (i >= path_len || path[i] != '[')
+                return false;
+            i++;
+            while (i < path_len && path[i] >= '0' && path[i] <= '9')
+                i++;
+            if (i >= path_len || path[i] != ']')
+                return false;
+            i++;
+            pattern += 3;
+            continue;
         }
+        if (i >= path_len || path[i] != *pattern)
+            return false;
+        i++;
+        pattern++;
     }
+    return i == path_len;
+}
 
-    *num_values = actual_num_values;
-    if (actual_num_values < array_size)
+// Report the value just read if its path is watched
+static void jsmn_stream_emit(jsmn_stream_parser *parser)
+{
+    parser->value[parser->value_len] = '\0';
+    parser->path[parser->path_len] = '\0';
+    if (!parser->callback)
+        return;
+    if (parser->watch_paths == NULL)
+    {
+        parser->callback(parser->path, parser->value, parser->context);
+        return;
+    }
+    for (size_t i = 0; i < parser->watch_count; i++)
     {
-        FuriString **reduced_values = (FuriString **)realloc(values, actual_num_values * sizeof(FuriString *));
-        if (reduced_values != NULL)
+        if (jsmn_stream_path_matches(parser->watch_paths[i], parser->path, parser->path_len))
         {
-            values = reduced_values;
+            parser->callback(parser->path, parser->value, parser->context);
+            return;
         }
     }
+}
 
-    free(tokens);
-    furi_string_free(array_str);
-    return values;
+// Append text to the current path, failing when it no longer fits
+static bool jsmn_stream_path_append(jsmn_stream_parser *parser, const char *text, size_t len)
+{
+    if (parser->path_len + len >= JSMN_STREAM_MAX_PATH)
+    {
+        parser->error = JSMN_ERROR_NOMEM;
+        return false;
+    }
+    memcpy(&parser->path[parser->path_len], text, len);
+    parser->path_len += len;
+    return true;
 }
 
-uint32_t json_token_count_furi(const FuriString *json)
+// Point the current path at the array element the top frame is on
+static bool jsmn_stream_path_index(jsmn_stream_parser *parser)
 {
-    if (json == NULL)
+    jsmn_stream_frame *frame = &parser->stack[parser->depth - 1];
+    char index[12];
+    int len = snprintf(index, sizeof(index), "[%d]", frame->index);
+    parser->path_len = frame->path_len;
+    return jsmn_stream_path_append(parser, index, (size_t)len);
+}
+
+void jsmn_stream_init_furi(
+    jsmn_stream_parser *parser,
+    const char *const *watch_paths,
+    size_t watch_count,
+    jsmn_stream_callback_furi callback,
+    void *context)
+{
+    parser->watch_paths = watch_paths;
+    parser->watch_count = watch_count;
+    parser->callback = callback;
+    parser->context = context;
+    jsmn_stream_reset_furi(parser);
+}
+
+void jsmn_stream_reset_furi(jsmn_stream_parser *parser)
+{
+    parser->state = JSMN_STREAM_VALUE;
+    parser->expect_key = false;
+    parser->is_key = false;
+    parser->depth = 0;
+    parser->error = 0;
+    parser->path_len = 0;
+    parser->value_len = 0;
+}
+
+// Handle one character outside of a string
+static void jsmn_stream_value_char(jsmn_stream_parser *parser, char c)
+{
+    jsmn_stream_frame *top = parser->depth > 0 ? &parser->stack[parser->depth - 1] : NULL;
+    switch (c)
     {
-        return JSMN_ERROR_INVAL;
+    case '\t':
+    case '\r':
+    case '\n':
+    case ' ':
+    case ':':
+        break;
+    case '{':
+    case '[':
+        if (parser->depth >= JSMN_STREAM_MAX_DEPTH)
+        {
+            parser->error = JSMN_ERROR_NOMEM;
+            return;
+        }
+        top = &parser->stack[parser->depth++];
+        top->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
+        top->path_len = parser->path_len;
+        top->index = 0;
+        if (c == '{')
+            parser->expect_key = true;
+        else
+            jsmn_stream_path_index(parser);
+        break;
+    case '}':
+    case ']':
+        if (!top || top->type != (c == '}' ? JSMN_OBJECT : JSMN_ARRAY))
+        {
+            parser->error = JSMN_ERROR_INVAL;
+            return;
+        }
+        parser->path_len = top->path_len;
+        parser->depth--;
+        parser->expect_key = false;
+        break;
+    case ',':
+        if (!top)
+        {
+            parser->error = JSMN_ERROR_INVAL;
+            return;
+        }
+        if (top->type == JSMN_OBJECT)
+        {
+            parser->path_len = top->path_len;
+            parser->expect_key = true;
+        }
+        else
+        {
+            top->index++;
+            jsmn_stream_path_index(parser);
+        }
+        break;
+    case '\"':
+        parser->state = JSMN_STREAM_STRING;
+        parser->is_key = top && top->type == JSMN_OBJECT && parser->expect_key;
+        parser->value_len = 0;
+        break;
+    default:
+        parser->state = JSMN_STREAM_PRIMITIVE;
+        parser->value[0] = c;
+        parser->value_len = 1;
+        break;
     }
+}
 
-    jsmn_parser parser;
-    jsmn_init_furi(&parser);
+// Append a character to the value being read (truncating long values)
+static void jsmn_stream_value_push(jsmn_stream_parser *parser, char c)
+{
+    if (parser->value_len < JSMN_STREAM_MAX_VALUE - 1)
+        parser->value[parser->value_len++] = c;
+}
 
-    // Pass NULL for tokens and 0 for num_tokens to get the token count only
-    int ret = jsmn_parse_furi(&parser, json, NULL, 0);
-    return ret; // If ret >= 0, it represents the number of tokens needed.
+int jsmn_stream_feed_furi(jsmn_stream_parser *parser, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len && parser->error == 0; i++)
+    {
+        char c = data[i];
+        switch (parser->state)
+        {
+        case JSMN_STREAM_STRING:
+            if (c == '\\')
+            {
+                parser->state = JSMN_STREAM_ESCAPE;
+            }
+            else if (c == '\"')
+            {
+                parser->state = JSMN_STREAM_VALUE;
+                if (parser->is_key)
+                {
+                    // the key completes the path of the value that follows
+                    parser->path_len = parser->stack[parser->depth - 1].path_len;
+                    if ((parser->path_len == 0 || jsmn_stream_path_append(parser, ".", 1)) &&
+                        jsmn_stream_path_append(parser, parser->value, parser->value_len))
+                    {
+                        parser->expect_key = false;
+                    }
+                    parser->value_len = 0;
+                }
+                else
+                {
+                    jsmn_stream_emit(parser);
+                }
+            }
+            else
+            {
+                jsmn_stream_value_push(parser, c);
+            }
+            break;
+        case JSMN_STREAM_ESCAPE:
+            switch (c)
+            {
+            case 'n':
+                c = '\n';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'u':
+                // keep \uXXXX as-is
+                jsmn_stream_value_push(parser, '\\');
+                break;
+            default:
+                break;
+            }
+            jsmn_stream_value_push(parser, c);
+            parser->state = JSMN_STREAM_STRING;
+            break;
+        case JSMN_STREAM_PRIMITIVE:
+            if (c == ',' || c == ']' || c == '}' || c == ':' ||
+                c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            {
+                jsmn_stream_emit(parser);
+                parser->state = JSMN_STREAM_VALUE;
+                jsmn_stream_value_char(parser, c);
+            }
+            else
+            {
+                jsmn_stream_value_push(parser, c);
+            }
+            break;
+        default:
+            jsmn_stream_value_char(parser, c);
+            break;
+        }
+    }
+    return parser->error;
 }
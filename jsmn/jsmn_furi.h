@@ -17,6 +17,7 @@
 #define JSMN_FURI_H
 
 #include <jsmn/jsmn_h.h>
+#include <arena/arena.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -49,12 +50,128 @@ extern "C"
 // Helper function to create a JSON object
 FuriString *get_json_furi(const FuriString *key, const FuriString *value);
 
+// View into a JSON document: a value without copying it (valid while the document lives)
+typedef struct
+{
+    const char *data; // start of the value in the source (NULL if not found)
+    size_t len;       // length of the value
+} FuriJSONSlice;
+
+// Copy a slice into a new FuriString (NULL for an empty slice); caller frees
+FuriString *json_slice_materialize_furi(FuriJSONSlice slice);
+// Copy a slice into a buffer (NUL terminated, truncated to fit)
+bool json_slice_copy_furi(FuriJSONSlice slice, char *buffer, size_t buffer_size);
+// Compare a slice with a C string
+bool json_slice_equal_furi(FuriJSONSlice slice, const char *str);
+
+// Slice variants of the lookups below; the slice points into json_data
+FuriJSONSlice get_json_value_slice_furi(const char *key, const FuriString *json_data);
+FuriJSONSlice get_json_array_value_slice_furi(const char *key, uint32_t index, const FuriString *json_data);
+
 // Updated signatures to accept const char* key
 FuriString *get_json_value_furi(const char *key, const FuriString *json_data);
 FuriString *get_json_array_value_furi(const char *key, uint32_t index, const FuriString *json_data);
 FuriString **get_json_array_values_furi(const char *key, const FuriString *json_data, int *num_values);
 
 uint32_t json_token_count_furi(const FuriString *json);
+
+// Parsed document: tokenized once, then queried by key, by array index or by iteration.
+// Results are token indexes; the value of a token is a (start, len) range into the source.
+typedef struct
+{
+    const FuriString *json; // source document (not owned, must outlive the doc)
+    jsmntok_t *tokens;      // tokens of the whole document
+    int count;              // number of tokens
+    Arena *arena;           // arena the tokens were carved from (NULL if on the heap)
+    size_t arena_mark;      // arena position to release back to when freed
+} FuriJSONDoc;
+
+// Carve document tokens from an arena instead of the heap (NULL to use the heap).
+// The calling thread owns the arena: only docs it parses use it, other threads get heap tokens.
+// Docs using the arena must be freed in the reverse order they were parsed, and nothing else
+// may reset the arena while one is alive.
+void json_set_arena_furi(Arena *arena);
+
+// Tokenize a document once; returns false on parse or memory failure
+bool json_doc_parse_furi(FuriJSONDoc *doc, const FuriString *json);
+void json_doc_free_furi(FuriJSONDoc *doc);
+
+// Token of the value for a key in an object token (-1 if missing)
+int json_doc_find_key_furi(const FuriJSONDoc *doc, int object, const char *key);
+// Token of an element in an array token (-1 if out of range)
+int json_doc_array_get_furi(const FuriJSONDoc *doc, int array, uint32_t index);
+// Iteration: first child of a container and the sibling after a token (-1 at the end)
+int json_doc_child_furi(const FuriJSONDoc *doc, int container);
+int json_doc_next_furi(const FuriJSONDoc *doc, int token);
+// Number of elements (arrays) or key/value pairs (objects) of a token
+int json_doc_size_furi(const FuriJSONDoc *doc, int token);
+
+// Range of a token's value in the source document
+bool json_doc_range_furi(const FuriJSONDoc *doc, int token, size_t *start, size_t *len);
+// View of a token's value in the source document
+FuriJSONSlice json_doc_slice_furi(const FuriJSONDoc *doc, int token);
+// Copy a token's value into a buffer (NUL terminated, truncated to fit)
+bool json_doc_copy_furi(const FuriJSONDoc *doc, int token, char *buffer, size_t buffer_size);
+
+// Streaming tokenizer: feed a document in arbitrary pieces (e.g. one UART line at a time)
+// and get a callback for every string/primitive value whose path is watched.
+// Paths look like "ssids[2].ssid"; a watched path may use "[*]" to match any array index.
+// In this app it parses the WiFi scan reply (fed from the flipper_http line hook) and the
+// wifi_list.txt import (fed from the file chunks); an HTTP body can be fed the same way,
+// from a hook set with flipper_http_set_line_callback.
+#define JSMN_STREAM_MAX_DEPTH 8   // maximum nesting of objects/arrays
+#define JSMN_STREAM_MAX_PATH 96   // maximum length of a value path
+#define JSMN_STREAM_MAX_VALUE 128 // maximum length of a reported value (longer values are truncated)
+
+typedef void (*jsmn_stream_callback_furi)(const char *path, const char *value, void *context);
+
+typedef enum
+{
+    JSMN_STREAM_VALUE,     // between tokens
+    JSMN_STREAM_STRING,    // inside a string
+    JSMN_STREAM_ESCAPE,    // after a backslash inside a string
+    JSMN_STREAM_PRIMITIVE, // inside a number/true/false/null
+} jsmn_stream_state_t;
+
+typedef struct
+{
+    jsmntype_t type;   // JSMN_OBJECT or JSMN_ARRAY
+    uint16_t path_len; // length of the container's own path
+    int index;         // current element index (arrays only)
+} jsmn_stream_frame;
+
+typedef struct
+{
+    jsmn_stream_state_t state;
+    bool expect_key; // the next string in the current object is a key
+    bool is_key;     // the string being read is a key
+    int depth;       // number of open containers
+    int error;       // first error hit (0 if none), input is ignored after an error
+    jsmn_stream_frame stack[JSMN_STREAM_MAX_DEPTH];
+    char path[JSMN_STREAM_MAX_PATH];
+    size_t path_len;
+    char value[JSMN_STREAM_MAX_VALUE];
+    size_t value_len;
+
+    const char *const *watch_paths; // paths to report (NULL to report every value)
+    size_t watch_count;
+    jsmn_stream_callback_furi callback;
+    void *context;
+} jsmn_stream_parser;
+
+// Set up a streaming parser with the paths to watch and the callback to fire
+void jsmn_stream_init_furi(
+    jsmn_stream_parser *parser,
+    const char *const *watch_paths,
+    size_t watch_count,
+    jsmn_stream_callback_furi callback,
+    void *context);
+
+// Reset the parse state for a new document (keeps the watched paths and callback)
+void jsmn_stream_reset_furi(jsmn_stream_parser *parser);
+
+// Feed the next piece of the document; returns 0 or a negative jsmnerr
+int jsmn_stream_feed_furi(jsmn_stream_parser *parser, const char *data, size_t len);
 /* Example usage:
 char *json = "{\"key1\":\"value1\",\"key2\":\"value2\"}";
 FuriString *json_data = char_to_furi_string(json);
@@ -0,0 +1,431 @@
+#include <scan/flip_wifi_scan.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Function to hand out the lowest free record id
+static uint8_t flip_wifi_scan_alloc_id(FlipWiFiScan *scan)
+{
+    for (size_t id = 0; id < scan->capacity; id++)
+    {
+        if (!(scan->used_ids[id / 32] & (1UL << (id % 32))))
+        {
+            scan->used_ids[id / 32] |= 1UL << (id % 32);
+            return id;
+        }
+    }
+    return 0; // not reached: callers check count < capacity first
+}
+
+// Function to give a record id back
+static void flip_wifi_scan_free_id(FlipWiFiScan *scan, uint8_t id)
+{
+    scan->used_ids[id / 32] &= ~(1UL << (id % 32));
+}
+
+// Function to add a finished record, keeping one entry per SSID in signal order
+static void flip_wifi_scan_commit(FlipWiFiScan *scan, const FlipWiFiScanRecord *record)
+{
+    if (record->ssid[0] == '\0')
+    {
+        return; // hidden networks have nothing to show or join
+    }
+
+    // the same SSID is seen once per access point; keep the strongest
+    // (a record kept from the previous scan is always replaced)
+    size_t slot = scan->count;
+    for (size_t i = 0; i < scan->count; i++)
+    {
+        if (strcmp(scan->records[i].ssid, record->ssid) == 0)
+        {
+            if (scan->records[i].fresh && scan->records[i].rssi >= record->rssi)
+            {
+                return;
+            }
+            slot = i;
+            break;
+        }
+    }
+    uint8_t id;
+    if (slot < scan->count)
+    {
+        id = scan->records[slot].id; // same network, keep its id
+    }
+    else if (scan->count < scan->capacity)
+    {
+        id = flip_wifi_scan_alloc_id(scan);
+    }
+    else
+    {
+        // full: push out the weakest record left from the previous scan, else the weakest
+        // one if this is stronger, and take over its id
+        slot = scan->count - 1;
+        for (size_t i = scan->count; i-- > 0;)
+        {
+            if (!scan->records[i].fresh)
+            {
+                slot = i;
+                break;
+            }
+        }
+        if (scan->records[slot].fresh && scan->records[slot].rssi >= record->rssi)
+        {
+            return;
+        }
+        id = scan->records[slot].id;
+    }
+
+    // take the old entry out, then insert in signal order (equal signals keep arrival order)
+    if (slot < scan->count)
+    {
+        memmove(&scan->records[slot], &scan->records[slot + 1], (scan->count - slot - 1) * sizeof(FlipWiFiScanRecord));
+        scan->count--;
+    }
+    size_t position = 0;
+    while (position < scan->count && scan->records[position].rssi >= record->rssi)
+    {
+        position++;
+    }
+    memmove(&scan->records[position + 1], &scan->records[position], (scan->count - position) * sizeof(FlipWiFiScanRecord));
+    scan->records[position] = *record;
+    scan->records[position].id = id;
+    scan->records[position].fresh = true;
+    scan->count++;
+}
+
+// Function to reset the record being filled in
+static void flip_wifi_scan_clear_pending(FlipWiFiScan *scan)
+{
+    memset(&scan->pending, 0, sizeof(FlipWiFiScanRecord));
+    scan->pending.rssi = FLIP_WIFI_SCAN_RSSI_UNKNOWN;
+    scan->pending_index = -1;
+}
+
+// Function to map the board's encryption field (ESP-IDF number or name) to FlipWiFiAuth
+static uint8_t flip_wifi_scan_parse_auth(const char *value)
+{
+    if (isdigit((unsigned char)value[0]))
+    {
+        // wifi_auth_mode_t
+        switch (atoi(value))
+        {
+        case 0:
+            return FlipWiFiAuthOpen;
+        case 1:
+            return FlipWiFiAuthWEP;
+        case 2:
+            return FlipWiFiAuthWPA;
+        case 3:
+        case 4:
+            return FlipWiFiAuthWPA2;
+        case 5:
+            return FlipWiFiAuthEnterprise;
+        case 6:
+        case 7:
+            return FlipWiFiAuthWPA3;
+        default:
+            return FlipWiFiAuthUnknown;
+        }
+    }
+    // names such as "WPA2_PSK" or "wpa2-enterprise"; compare upper-cased
+    char name[24];
+    size_t length = 0;
+    for (; value[length] && length < sizeof(name) - 1; length++)
+    {
+        name[length] = toupper((unsigned char)value[length]);
+    }
+    name[length] = '\0';
+    if (strstr(name, "ENTERPRISE") || strstr(name, "EAP"))
+        return FlipWiFiAuthEnterprise;
+    if (strstr(name, "WPA3"))
+        return FlipWiFiAuthWPA3;
+    if (strstr(name, "WPA2"))
+        return FlipWiFiAuthWPA2;
+    if (strstr(name, "WPA"))
+        return FlipWiFiAuthWPA;
+    if (strstr(name, "WEP"))
+        return FlipWiFiAuthWEP;
+    if (strstr(name, "OPEN") || strstr(name, "NONE"))
+        return FlipWiFiAuthOpen;
+    return FlipWiFiAuthUnknown;
+}
+
+// Function to collect the fields of each network object from the streaming parser
+// Paths look like "networks[3].rssi" (or "[3].rssi" for a bare array)
+static void flip_wifi_scan_json_value(const char *path, const char *value, void *context)
+{
+    FlipWiFiScan *scan = (FlipWiFiScan *)context;
+    const char *close = strrchr(path, ']');
+    const char *open = strrchr(path, '[');
+    if (!close || !open || open > close || close[1] != '.')
+    {
+        return;
+    }
+    int index = atoi(open + 1);
+    const char *key = close + 2;
+
+    // a new array index means the previous object is complete
+    if (index != scan->pending_index)
+    {
+        if (scan->pending_index >= 0)
+        {
+            flip_wifi_scan_commit(scan, &scan->pending);
+        }
+        flip_wifi_scan_clear_pending(scan);
+        scan->pending_index = index;
+    }
+
+    if (strcmp(key, "ssid") == 0)
+    {
+        snprintf(scan->pending.ssid, sizeof(scan->pending.ssid), "%s", value);
+    }
+    else if (strcmp(key, "rssi") == 0)
+    {
+        int rssi = atoi(value);
+        scan->pending.rssi = rssi < INT8_MIN + 1 ? INT8_MIN + 1 : (rssi > 0 ? 0 : rssi);
+    }
+    else if (strcmp(key, "channel") == 0)
+    {
+        scan->pending.channel = (uint8_t)atoi(value);
+    }
+    else if (strcmp(key, "encryption") == 0 || strcmp(key, "auth") == 0)
+    {
+        scan->pending.auth = flip_wifi_scan_parse_auth(value);
+    }
+}
+
+// Function to split a legacy comma separated reply into SSID-only records
+static void flip_wifi_scan_feed_csv(FlipWiFiScan *scan, const char *line, size_t length)
+{
+    FlipWiFiScanRecord record;
+    memset(&record, 0, sizeof(record));
+    record.rssi = FLIP_WIFI_SCAN_RSSI_UNKNOWN;
+
+    size_t start = 0;
+    while (start <= length)
+    {
+        size_t end = start;
+        while (end < length && line[end] != ',')
+        {
+            end++;
+        }
+        // trim by offsets, the line is not modified
+        size_t first = start;
+        size_t last = end;
+        while (first < last && isspace((unsigned char)line[first]))
+            first++;
+        while (last > first && isspace((unsigned char)line[last - 1]))
+            last--;
+        if (last > first)
+        {
+            size_t ssid_length = last - first;
+            if (ssid_length > FLIP_WIFI_SCAN_SSID_LENGTH - 1)
+            {
+                ssid_length = FLIP_WIFI_SCAN_SSID_LENGTH - 1;
+            }
+            memcpy(record.ssid, &line[first], ssid_length);
+            record.ssid[ssid_length] = '\0';
+            flip_wifi_scan_commit(scan, &record);
+        }
+        start = end + 1;
+    }
+}
+
+void flip_wifi_scan_begin(FlipWiFiScan *scan, FlipWiFiScanRecord *records, size_t capacity)
+{
+    scan->records = records;
+    scan->count = 0;
+    scan->capacity = records ? capacity : 0;
+    if (scan->capacity > UINT8_MAX + 1)
+    {
+        scan->capacity = UINT8_MAX + 1; // ids are 8-bit
+    }
+    scan->refreshing = false;
+    memset(scan->used_ids, 0, sizeof(scan->used_ids));
+    scan->is_json = false;
+    scan->started = false;
+    flip_wifi_scan_clear_pending(scan);
+    jsmn_stream_init_furi(&scan->json, NULL, 0, flip_wifi_scan_json_value, scan);
+}
+
+void flip_wifi_scan_refresh(FlipWiFiScan *scan)
+{
+    for (size_t i = 0; i < scan->count; i++)
+    {
+        scan->records[i].fresh = false;
+    }
+    scan->refreshing = true;
+    scan->is_json = false;
+    scan->started = false;
+    flip_wifi_scan_clear_pending(scan);
+    jsmn_stream_reset_furi(&scan->json);
+}
+
+bool flip_wifi_scan_feed_line(const char *line, size_t length, void *context)
+{
+    FlipWiFiScan *scan = (FlipWiFiScan *)context;
+    if (!scan || !line || scan->capacity == 0)
+    {
+        return false;
+    }
+    if (!scan->started)
+    {
+        size_t i = 0;
+        while (i < length && isspace((unsigned char)line[i]))
+            i++;
+        if (i == length)
+        {
+            return false;
+        }
+        scan->started = true;
+        scan->is_json = line[i] == '{' || line[i] == '[';
+    }
+    if (!scan->is_json)
+    {
+        // the legacy reply lists every network on one line
+        flip_wifi_scan_feed_csv(scan, line, length);
+        return true;
+    }
+    // the JSON may span lines; it is over once its outer object or array closes
+    if (jsmn_stream_feed_furi(&scan->json, line, length) < 0 ||
+        jsmn_stream_feed_furi(&scan->json, "\n", 1) < 0)
+    {
+        return true; // nothing more can be parsed from this reply
+    }
+    return scan->json.depth == 0;
+}
+
+void flip_wifi_scan_end(FlipWiFiScan *scan, bool complete)
+{
+    if (scan->pending_index >= 0)
+    {
+        flip_wifi_scan_commit(scan, &scan->pending);
+        flip_wifi_scan_clear_pending(scan);
+    }
+    if (scan->refreshing)
+    {
+        // networks a full reply did not mention are gone
+        size_t kept = 0;
+        for (size_t i = 0; i < scan->count; i++)
+        {
+            if (scan->records[i].fresh || !complete)
+            {
+                scan->records[i].fresh = true;
+                scan->records[kept++] = scan->records[i];
+            }
+            else
+            {
+                flip_wifi_scan_free_id(scan, scan->records[i].id);
+            }
+        }
+        scan->count = kept;
+        scan->refreshing = false;
+    }
+}
+
+bool flip_wifi_scan_save(const FlipWiFiScan *scan, Storage *storage, const char *path, uint32_t timestamp)
+{
+    File *file = storage_file_alloc(storage);
+    if (!storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS))
+    {
+        storage_file_free(file);
+        return false;
+    }
+    char line[FLIP_WIFI_SCAN_SSID_LENGTH + 24];
+    int length = snprintf(line, sizeof(line), "%lu\n", (unsigned long)timestamp);
+    bool saved = storage_file_write(file, line, length) == (size_t)length;
+    for (size_t i = 0; saved && i < scan->count; i++)
+    {
+        const FlipWiFiScanRecord *record = &scan->records[i];
+        // the SSID goes last so commas in it need no escaping
+        length = snprintf(line, sizeof(line), "%d,%u,%u,%s\n", record->rssi, record->channel, record->auth, record->ssid);
+        saved = storage_file_write(file, line, length) == (size_t)length;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    return saved;
+}
+
+bool flip_wifi_scan_load(FlipWiFiScan *scan, Storage *storage, const char *path, uint32_t *timestamp)
+{
+    File *file = storage_file_alloc(storage);
+    if (!storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING))
+    {
+        storage_file_free(file);
+        return false;
+    }
+    // a full list is a few KB; anything bigger is not one of ours
+    size_t size = storage_file_size(file);
+    char *data = size > 0 && size <= scan->capacity * (FLIP_WIFI_SCAN_SSID_LENGTH + 24) ? malloc(size + 1) : NULL;
+    bool loaded = data && storage_file_read(file, data, size) == size;
+    storage_file_close(file);
+    storage_file_free(file);
+    if (!loaded)
+    {
+        free(data);
+        return false;
+    }
+    data[size] = '\0';
+
+    char *line = data;
+    char *next = strchr(line, '\n');
+    *timestamp = strtoul(line, NULL, 10);
+    while (next)
+    {
+        line = next + 1;
+        next = strchr(line, '\n');
+        if (next)
+        {
+            *next = '\0';
+        }
+        FlipWiFiScanRecord record;
+        memset(&record, 0, sizeof(record));
+        char *field = line;
+        record.rssi = (int8_t)strtol(field, &field, 10);
+        if (*field++ != ',')
+            continue;
+        record.channel = (uint8_t)strtoul(field, &field, 10);
+        if (*field++ != ',')
+            continue;
+        record.auth = (uint8_t)strtoul(field, &field, 10);
+        if (*field++ != ',')
+            continue;
+        snprintf(record.ssid, sizeof(record.ssid), "%s", field);
+        flip_wifi_scan_commit(scan, &record);
+    }
+    free(data);
+    return true;
+}
+
+const FlipWiFiScanRecord *flip_wifi_scan_find(const FlipWiFiScan *scan, uint8_t id)
+{
+    for (size_t i = 0; i < scan->count; i++)
+    {
+        if (scan->records[i].id == id)
+        {
+            return &scan->records[i];
+        }
+    }
+    return NULL;
+}
+
+const char *flip_wifi_scan_auth_name(uint8_t auth)
+{
+    switch (auth)
+    {
+    case FlipWiFiAuthOpen:
+        return "Open";
+    case FlipWiFiAuthWEP:
+        return "WEP";
+    case FlipWiFiAuthWPA:
+        return "WPA";
+    case FlipWiFiAuthWPA2:
+        return "WPA2";
+    case FlipWiFiAuthWPA3:
+        return "WPA3";
+    case FlipWiFiAuthEnterprise:
+        return "Enterprise";
+    default:
+        return "";
+    }
+}
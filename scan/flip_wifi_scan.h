@@ -0,0 +1,72 @@
+#pragma once
+#include <furi.h>
+#include <storage/storage.h>
+#include <jsmn/jsmn_furi.h>
+
+// Scan results are built straight from the [WIFI/SCAN] reply lines as the UART worker
+// hands them over. The board either answers with a comma separated list of SSIDs (older
+// FlipperHTTP firmware) or with JSON objects carrying ssid/rssi/channel/encryption.
+// Records are kept sorted by signal strength, strongest first, with one entry per SSID.
+#define FLIP_WIFI_SCAN_SSID_LENGTH 33      // 802.11 SSIDs are at most 32 bytes
+#define FLIP_WIFI_SCAN_RSSI_UNKNOWN INT8_MIN // the board did not report a signal strength
+
+typedef enum
+{
+    FlipWiFiAuthUnknown,
+    FlipWiFiAuthOpen,
+    FlipWiFiAuthWEP,
+    FlipWiFiAuthWPA,
+    FlipWiFiAuthWPA2,
+    FlipWiFiAuthWPA3,
+    FlipWiFiAuthEnterprise,
+} FlipWiFiAuth;
+
+typedef struct
+{
+    char ssid[FLIP_WIFI_SCAN_SSID_LENGTH];
+    int8_t rssi;     // dBm, FLIP_WIFI_SCAN_RSSI_UNKNOWN if not reported
+    uint8_t channel; // 0 if not reported
+    uint8_t auth;    // FlipWiFiAuth
+    uint8_t id;      // stable slot id (survives re-sorting), below the scan capacity
+    bool fresh;      // seen by the current scan (false for kept records during a refresh)
+} FlipWiFiScanRecord;
+
+typedef struct
+{
+    FlipWiFiScanRecord *records; // sorted by rssi, strongest first
+    size_t count;
+    size_t capacity;
+    uint32_t used_ids[8];        // bitmap of the ids handed out
+    bool refreshing;             // updating kept records instead of starting empty
+
+    FlipWiFiScanRecord pending; // JSON record still being filled in
+    int pending_index;          // array index of the pending record (-1 if none)
+    bool is_json;               // reply format, decided by the first payload line
+    bool started;               // a payload line has been seen
+    jsmn_stream_parser json;
+} FlipWiFiScan;
+
+// Function to start a new scan into a caller-provided record array
+void flip_wifi_scan_begin(FlipWiFiScan *scan, FlipWiFiScanRecord *records, size_t capacity);
+
+// Function to feed one reply line (matches the FlipperHTTP payload line callback);
+// returns true once the reply is over: the CSV line, or the closing bracket of the JSON
+bool flip_wifi_scan_feed_line(const char *line, size_t length, void *context);
+
+// Function to scan again over the current records: they stay listed, are updated as
+// the reply comes in, and the ones the new reply does not mention are dropped at the end
+void flip_wifi_scan_refresh(FlipWiFiScan *scan);
+
+// Function to finish the scan, committing a record that was still being filled in
+// (an incomplete refresh keeps the records the reply did not get to)
+void flip_wifi_scan_end(FlipWiFiScan *scan, bool complete);
+
+// Functions to persist the records as text: a timestamp line, then "rssi,channel,auth,ssid" lines
+bool flip_wifi_scan_save(const FlipWiFiScan *scan, Storage *storage, const char *path, uint32_t timestamp);
+bool flip_wifi_scan_load(FlipWiFiScan *scan, Storage *storage, const char *path, uint32_t *timestamp);
+
+// Function to find a record by its stable id (NULL if it is gone)
+const FlipWiFiScanRecord *flip_wifi_scan_find(const FlipWiFiScan *scan, uint8_t id);
+
+// Function to get a readable name for an authentication mode
+const char *flip_wifi_scan_auth_name(uint8_t auth);
@@ -35,8 +35,25 @@ typedef struct
     void *validator_callback_context;
     FuriString *validator_text;
     bool valadator_message_visible;
+
+    bool mode_at;              // header is mode_AT, decided when the header is set
+    uint8_t glyph_widths[95];  // FontSecondary widths of ' '..'~', 0 until first measured
+    size_t window_length;      // text length the visible window was computed for
+    size_t window_start;       // index of the first visible character
+    uint8_t window_width;      // pixel width of the visible characters
+    bool window_clipped;       // text starts before the window, "..." is drawn
 } UART_TextInputModel;
 
+// Input state compared before and after a key press to decide whether to redraw
+typedef struct
+{
+    uint8_t selected_row;
+    uint8_t selected_column;
+    size_t text_length;
+    bool clear_default_text;
+    bool valadator_message_visible;
+} UART_TextInputState;
+
 static const uint8_t keyboard_origin_x = 1;
 static const uint8_t keyboard_origin_y = 29;
 static const uint8_t keyboard_row_count = 4;
@@ -46,6 +63,8 @@ static const uint8_t keyboard_row_count = 4;
 #define ENTER_KEY '\r'
 #define BACKSPACE_KEY '\b'
 
+#define WINDOW_STALE SIZE_MAX // window_length value forcing the visible window to be rebuilt
+
 static const UART_TextInputKey keyboard_keys_row_1[] = {
     {'{', 1, 0},
     {'(', 9, 0},
@@ -271,46 +290,98 @@ static void uart_text_input_backspace_cb(UART_TextInputModel *model)
     if (text_length > 0)
     {
         model->text_buffer[text_length - 1] = 0;
+        model->window_length = WINDOW_STALE;
     }
 }
 
+// Function to get the width of a character in the text field font, measuring it once
+static uint8_t
+uart_text_input_glyph_width(Canvas *canvas, UART_TextInputModel *model, char glyph)
+{
+    uint8_t index = (uint8_t)glyph - ' ';
+    if (index >= sizeof(model->glyph_widths))
+    {
+        return canvas_glyph_width(canvas, (uint8_t)glyph);
+    }
+    if (model->glyph_widths[index] == 0)
+    {
+        model->glyph_widths[index] = canvas_glyph_width(canvas, (uint8_t)glyph);
+    }
+    return model->glyph_widths[index];
+}
+
+// Function to find the tail of the text that fits the text field, only when the text changed
+static void
+uart_text_input_update_window(Canvas *canvas, UART_TextInputModel *model, const char *text)
+{
+    const size_t length = strlen(text);
+    if (model->window_length == length)
+    {
+        return;
+    }
+
+    // walk back from the end so only the characters that end up on screen are measured
+    const uint8_t available = canvas_width(canvas) - 8;
+    size_t start = length;
+    uint16_t width = 0;
+    while (start > 0)
+    {
+        uint8_t glyph = uart_text_input_glyph_width(canvas, model, text[start - 1]);
+        if (width + glyph > available)
+        {
+            break;
+        }
+        width += glyph;
+        start--;
+    }
+
+    model->window_clipped = start > 0;
+    if (model->window_clipped)
+    {
+        // the "..." prefix takes another 8 pixels
+        while (width > available - 8)
+        {
+            width -= uart_text_input_glyph_width(canvas, model, text[start]);
+            start++;
+        }
+    }
+
+    model->window_length = length;
+    model->window_start = start;
+    model->window_width = width;
+}
+
 static void uart_text_input_view_draw_callback(Canvas *canvas, void *_model)
 {
     UART_TextInputModel *model = _model;
-    // uint8_t text_length = model->text_buffer ? strlen(model->text_buffer) : 0;
-    uint8_t needed_string_width = canvas_width(canvas) - 8;
     uint8_t start_pos = 4;
 
-    const char *text = model->text_buffer;
+    const char *text = model->text_buffer ? model->text_buffer : "";
 
     canvas_clear(canvas);
     canvas_set_color(canvas, ColorBlack);
+    canvas_set_font(canvas, FontSecondary);
 
     canvas_draw_str(canvas, 2, 7, model->header);
     elements_slightly_rounded_frame(canvas, 1, 8, 126, 12);
 
-    if (canvas_string_width(canvas, text) > needed_string_width)
+    uart_text_input_update_window(canvas, model, text);
+    if (model->window_clipped)
     {
         canvas_draw_str(canvas, start_pos, 17, "...");
         start_pos += 6;
-        needed_string_width -= 8;
-    }
-
-    while (text != 0 && canvas_string_width(canvas, text) > needed_string_width)
-    {
-        text++;
     }
+    text += model->window_start;
 
     if (model->clear_default_text)
     {
-        elements_slightly_rounded_box(
-            canvas, start_pos - 1, 14, canvas_string_width(canvas, text) + 2, 10);
+        elements_slightly_rounded_box(canvas, start_pos - 1, 14, model->window_width + 2, 10);
         canvas_set_color(canvas, ColorWhite);
     }
     else
     {
-        canvas_draw_str(canvas, start_pos + canvas_string_width(canvas, text) + 1, 18, "|");
-        canvas_draw_str(canvas, start_pos + canvas_string_width(canvas, text) + 2, 18, "|");
+        canvas_draw_str(canvas, start_pos + model->window_width + 1, 18, "|");
+        canvas_draw_str(canvas, start_pos + model->window_width + 2, 18, "|");
     }
     canvas_draw_str(canvas, start_pos, 17, text);
 
@@ -380,7 +451,7 @@ static void uart_text_input_view_draw_callback(Canvas *canvas, void *_model)
                 {
                     canvas_set_color(canvas, ColorBlack);
                 }
-                if (0 == strcmp(model->header, mode_AT))
+                if (model->mode_at)
                 {
                     canvas_draw_glyph(
                         canvas,
@@ -477,14 +548,14 @@ static void uart_text_input_handle_ok(
     char selected = get_selected_char(model);
     uint8_t text_length = strlen(model->text_buffer);
 
-    if (0 == strcmp(model->header, mode_AT))
+    if (model->mode_at)
     {
         selected = char_to_uppercase(selected);
     }
 
     if (shift)
     {
-        if (0 == strcmp(model->header, mode_AT))
+        if (model->mode_at)
         {
             selected = char_to_lowercase(selected);
         }
@@ -522,11 +593,25 @@ static void uart_text_input_handle_ok(
         {
             model->text_buffer[text_length] = selected;
             model->text_buffer[text_length + 1] = 0;
+            model->window_length = WINDOW_STALE;
         }
     }
     model->clear_default_text = false;
 }
 
+// Function to capture what a key press can change, to tell whether the view needs a redraw
+static UART_TextInputState uart_text_input_get_state(const UART_TextInputModel *model)
+{
+    UART_TextInputState state = {
+        .selected_row = model->selected_row,
+        .selected_column = model->selected_column,
+        .text_length = model->text_buffer ? strlen(model->text_buffer) : 0,
+        .clear_default_text = model->clear_default_text,
+        .valadator_message_visible = model->valadator_message_visible,
+    };
+    return state;
+}
+
 static bool uart_text_input_view_input_callback(InputEvent *event, void *context)
 {
     UART_TextInput *uart_text_input = context;
@@ -536,6 +621,7 @@ static bool uart_text_input_view_input_callback(InputEvent *event, void *context
 
     // Acquire model
     UART_TextInputModel *model = view_get_model(uart_text_input->view);
+    const UART_TextInputState before = uart_text_input_get_state(model);
 
     if ((!(event->type == InputTypePress) && !(event->type == InputTypeRelease)) &&
         model->valadator_message_visible)
@@ -622,8 +708,14 @@ static bool uart_text_input_view_input_callback(InputEvent *event, void *context
         }
     }
 
-    // Commit model
-    view_commit_model(uart_text_input->view, consumed);
+    // Commit model, redrawing only if the key press changed something on screen
+    const UART_TextInputState after = uart_text_input_get_state(model);
+    const bool changed = before.selected_row != after.selected_row ||
+                         before.selected_column != after.selected_column ||
+                         before.text_length != after.text_length ||
+                         before.clear_default_text != after.clear_default_text ||
+                         before.valadator_message_visible != after.valadator_message_visible;
+    view_commit_model(uart_text_input->view, consumed && changed);
 
     return consumed;
 }
@@ -702,6 +794,8 @@ void uart_text_input_reset(UART_TextInput *uart_text_input)
             model->validator_callback_context = NULL;
             furi_string_reset(model->validator_text);
             model->valadator_message_visible = false;
+            model->mode_at = false;
+            model->window_length = WINDOW_STALE;
         },
         true);
 }
@@ -729,6 +823,7 @@ void uart_text_input_set_result_callback(
             model->text_buffer = text_buffer;
             model->text_buffer_size = text_buffer_size;
             model->clear_default_text = clear_default_text;
+            model->window_length = WINDOW_STALE;
             if (text_buffer && text_buffer[0] != '\0')
             {
                 // Set focus on Save
@@ -780,5 +875,11 @@ void *uart_text_input_get_validator_callback_context(UART_TextInput *uart_text_i
 void uart_text_input_set_header_text(UART_TextInput *uart_text_input, const char *text)
 {
     with_view_model(
-        uart_text_input->view, UART_TextInputModel * model, { model->header = text; }, true);
+        uart_text_input->view,
+        UART_TextInputModel * model,
+        {
+            model->header = text;
+            model->mode_at = text && 0 == strcmp(text, mode_AT);
+        },
+        true);
 }